@@ -0,0 +1,27 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+// One direction of the separable Gaussian, for contexts without compute
+// shaders. Neighbouring taps are merged into one bilinear fetch placed
+// between them by their weights, so a radius of r takes r / 2 + 1 fetches.
+#define MAX_TAPS 9
+
+uniform sampler2D image;
+uniform vec2 direction;
+uniform int tapCount;
+uniform float offsets[MAX_TAPS];
+uniform float weights[MAX_TAPS];
+
+void main()
+{
+    vec2 texelStep = direction / textureSize(image, 0);
+    vec3 result = texture(image, TexCoords).rgb * weights[0];
+    for (int i = 1; i < tapCount; i++)
+    {
+        result += texture(image, TexCoords + texelStep * offsets[i]).rgb * weights[i];
+        result += texture(image, TexCoords - texelStep * offsets[i]).rgb * weights[i];
+    }
+    FragColor = vec4(result, 1.0);
+}
@@ -0,0 +1,69 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D image;
+// the first downsample reads the HDR scene: it keeps only what is brighter
+// than threshold (with a soft knee so highlights fade in rather than pop)
+// and weights each 2x2 block by its luminance so single hot pixels don't
+// flicker as they move across the chain
+uniform bool prefilter;
+uniform float threshold;
+uniform float knee;
+
+float luminance(vec3 color)
+{
+    return dot(color, vec3(0.2126, 0.7152, 0.0722));
+}
+
+vec3 karisAverage(vec3 a, vec3 b, vec3 c, vec3 d)
+{
+    vec4 weights = 1.0 / (1.0 + vec4(luminance(a), luminance(b), luminance(c), luminance(d)));
+    return (a * weights.x + b * weights.y + c * weights.z + d * weights.w) / dot(weights, vec4(1.0));
+}
+
+vec3 applyThreshold(vec3 color)
+{
+    float brightness = luminance(color);
+    float soft = clamp(brightness - threshold + knee, 0.0, 2.0 * knee);
+    soft = soft * soft / (4.0 * knee + 0.0001);
+    return color * max(soft, brightness - threshold) / max(brightness, 0.0001);
+}
+
+void main()
+{
+    // 13 bilinear taps over a 6x6 texel footprint of the source, as five
+    // overlapping 2x2 boxes: one in the centre and one per corner
+    vec2 texel = 1.0 / textureSize(image, 0);
+    vec3 a = texture(image, TexCoords + texel * vec2(-2.0,  2.0)).rgb;
+    vec3 b = texture(image, TexCoords + texel * vec2( 0.0,  2.0)).rgb;
+    vec3 c = texture(image, TexCoords + texel * vec2( 2.0,  2.0)).rgb;
+    vec3 d = texture(image, TexCoords + texel * vec2(-2.0,  0.0)).rgb;
+    vec3 e = texture(image, TexCoords).rgb;
+    vec3 f = texture(image, TexCoords + texel * vec2( 2.0,  0.0)).rgb;
+    vec3 g = texture(image, TexCoords + texel * vec2(-2.0, -2.0)).rgb;
+    vec3 h = texture(image, TexCoords + texel * vec2( 0.0, -2.0)).rgb;
+    vec3 i = texture(image, TexCoords + texel * vec2( 2.0, -2.0)).rgb;
+    vec3 j = texture(image, TexCoords + texel * vec2(-1.0,  1.0)).rgb;
+    vec3 k = texture(image, TexCoords + texel * vec2( 1.0,  1.0)).rgb;
+    vec3 l = texture(image, TexCoords + texel * vec2(-1.0, -1.0)).rgb;
+    vec3 m = texture(image, TexCoords + texel * vec2( 1.0, -1.0)).rgb;
+
+    vec3 result;
+    if (prefilter)
+    {
+        result = karisAverage(j, k, l, m) * 0.5
+               + (karisAverage(a, b, d, e) + karisAverage(b, c, e, f)
+                + karisAverage(d, e, g, h) + karisAverage(e, f, h, i)) * 0.125;
+        result = applyThreshold(result);
+    }
+    else
+    {
+        result = e * 0.125
+               + (a + c + g + i) * 0.03125
+               + (b + d + f + h) * 0.0625
+               + (j + k + l + m) * 0.125;
+    }
+    FragColor = vec4(max(result, vec3(0.0)), 1.0);
+}
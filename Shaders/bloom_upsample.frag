@@ -0,0 +1,26 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+// the next smaller level of the chain; the result is blended additively onto
+// the level being drawn, so every level ends up summed into the largest one
+uniform sampler2D image;
+// tent width in source texels
+uniform float filterRadius;
+
+void main()
+{
+    // 3x3 tent: 1 2 1 / 2 4 2 / 1 2 1
+    vec2 offset = filterRadius / textureSize(image, 0);
+    vec3 result = texture(image, TexCoords).rgb * 4.0;
+    result += (texture(image, TexCoords + vec2(-offset.x, 0.0)).rgb
+             + texture(image, TexCoords + vec2( offset.x, 0.0)).rgb
+             + texture(image, TexCoords + vec2(0.0, -offset.y)).rgb
+             + texture(image, TexCoords + vec2(0.0,  offset.y)).rgb) * 2.0;
+    result += texture(image, TexCoords + vec2(-offset.x, -offset.y)).rgb
+            + texture(image, TexCoords + vec2( offset.x, -offset.y)).rgb
+            + texture(image, TexCoords + vec2(-offset.x,  offset.y)).rgb
+            + texture(image, TexCoords + vec2( offset.x,  offset.y)).rgb;
+    FragColor = vec4(result / 16.0, 1.0);
+}
@@ -0,0 +1,83 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+// Every post stage in one pass, each compiled in by its define
+// (PostProcess, postShaderKeys)
+uniform sampler2D scene;
+#ifdef BLOOM
+uniform sampler2D bloomBlur;
+uniform float bloomStrength;
+#endif
+#ifdef TONEMAP
+uniform float exposure;
+#endif
+#ifdef AUTO_EXPOSURE
+// 1x1, written by luminance_average.comp this frame
+uniform sampler2D autoExposure;
+#endif
+#ifdef SHARPEN
+uniform float sharpness;
+uniform vec2 sourceTexel;
+#endif
+#ifdef GAMMA
+uniform float gamma;
+#endif
+#ifdef COLOR_GRADING
+uniform sampler3D gradingLut;
+uniform float lutSize;
+uniform float gradingAmount;
+#endif
+
+float exposureScale;
+
+vec3 tonemap(vec3 color)
+{
+#ifdef TONEMAP
+    return vec3(1.0) - exp(-color * exposureScale);
+#else
+    return color;
+#endif
+}
+
+void main()
+{
+#ifdef TONEMAP
+    exposureScale = exposure;
+#endif
+#ifdef AUTO_EXPOSURE
+    exposureScale *= texelFetch(autoExposure, ivec2(0), 0).r;
+#endif
+    vec3 bloomColor = vec3(0.0);
+#ifdef BLOOM
+    bloomColor = texture(bloomBlur, TexCoords).rgb * bloomStrength;
+#endif
+    vec3 color = tonemap(texture(scene, TexCoords).rgb + bloomColor);
+#ifdef SHARPEN
+    // The scene was stretched bilinearly to the output or blurred a little by
+    // temporal accumulation. Contrast adaptive sharpening against the
+    // neighbours one scene texel away brings the edges back, less where
+    // contrast is already high so they don't ring. The bloom is smooth
+    // enough to share one sample.
+    vec3 north = tonemap(texture(scene, TexCoords + vec2(0.0, sourceTexel.y)).rgb + bloomColor);
+    vec3 south = tonemap(texture(scene, TexCoords - vec2(0.0, sourceTexel.y)).rgb + bloomColor);
+    vec3 east = tonemap(texture(scene, TexCoords + vec2(sourceTexel.x, 0.0)).rgb + bloomColor);
+    vec3 west = tonemap(texture(scene, TexCoords - vec2(sourceTexel.x, 0.0)).rgb + bloomColor);
+    vec3 minimum = clamp(min(color, min(min(north, south), min(east, west))), 0.0, 1.0);
+    vec3 maximum = clamp(max(color, max(max(north, south), max(east, west))), 0.0, 1.0);
+    vec3 amount = sqrt(clamp(min(minimum, 1.0 - maximum) / max(maximum, vec3(1.0 / 1024.0)), 0.0, 1.0));
+    vec3 weight = -amount / mix(8.0, 5.0, sharpness);
+    color = clamp((color + (north + south + east + west) * weight) / (1.0 + 4.0 * weight), 0.0, 1.0);
+#endif
+#ifdef GAMMA
+    color = pow(color, vec3(1.0 / gamma));
+#endif
+#ifdef COLOR_GRADING
+    // the LUT maps display colours; scale into the centres of its edge
+    // texels so 0 and 1 are not blended with the border
+    vec3 lutCoord = clamp(color, 0.0, 1.0) * ((lutSize - 1.0) / lutSize) + 0.5 / lutSize;
+    color = mix(color, texture(gradingLut, lutCoord).rgb, gradingAmount);
+#endif
+    FragColor = vec4(color, 1.0);
+}
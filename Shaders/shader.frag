@@ -1,35 +1,89 @@
 #version 330 core
-out vec4 FragColor;
+layout (location = 0) out vec4 FragColor;
+// screen-space motion since last frame in UV units, for TemporalAA
+layout (location = 1) out vec2 Velocity;
 
 in vec2 TexCoord;
 in vec3 FragPos;
 in vec3 Normal;
+in vec4 CurrentClip;
+in vec4 PreviousClip;
 
+#if defined(USE_VIRTUAL_TEXTURE)
+// see VirtualTexture::setUniforms
+uniform sampler2D vtCache;
+uniform sampler2D vtIndirection;
+uniform vec4 vtLayout;      // virtual size in texels, pages per side at mip 0, last mip, lod bias
+uniform vec4 vtCacheLayout; // tile size, border, padded tile size, 1 / cache size in texels
+#elif defined(USE_TEXTURE_ARRAY)
+uniform sampler2DArray textureArray;
+flat in float TextureLayer;
+flat in vec4 UVRect;
+#elif defined(USE_TEXTURE)
 uniform sampler2D texture1;
-uniform vec3 lightPos;
-uniform vec3 lightColor;
-uniform vec3 objectColor;
-uniform bool useTexture;
+#endif
+
+layout (std140) uniform FrameData
+{
+    mat4 view;
+    mat4 projection;
+    vec4 lightPos;
+    vec4 lightColor;
+    vec4 objectColor;
+    vec4 jitter; // xy: NDC offset in this frame's MVPs
+};
+
+#if defined(USE_VIRTUAL_TEXTURE)
+// Samples the page the feedback pass requests for this pixel, or the nearest
+// resident ancestor the indirection table points at until it is streamed in
+vec4 sampleVirtual(vec2 uv)
+{
+    vec2 dx = dFdx(uv) * vtLayout.x;
+    vec2 dy = dFdy(uv) * vtLayout.x;
+    float lod = 0.5 * log2(max(dot(dx, dx), dot(dy, dy))) + vtLayout.w;
+    float mip = clamp(floor(lod), 0.0, vtLayout.z);
+    float pages = max(floor(vtLayout.y / exp2(mip)), 1.0);
+    ivec2 page = ivec2(clamp(floor(uv * pages), vec2(0.0), vec2(pages - 1.0)));
+
+    // cache slot (xy) and mip (z) of what is actually resident
+    vec3 entry = floor(texelFetch(vtIndirection, page, int(mip)).xyz * 255.0 + 0.5);
+    float mappedPages = max(floor(vtLayout.y / exp2(entry.z)), 1.0);
+    vec2 inPage = uv * mappedPages - clamp(floor(uv * mappedPages), vec2(0.0), vec2(mappedPages - 1.0));
+
+    vec2 texel = entry.xy * vtCacheLayout.z + vtCacheLayout.y + inPage * vtCacheLayout.x;
+    return textureLod(vtCache, texel * vtCacheLayout.w, 0.0);
+}
+#endif
 
 void main()
 {
     // Ambient
     float ambientStrength = 0.1;
-    vec3 ambient = ambientStrength * lightColor;
+    vec3 ambient = ambientStrength * lightColor.rgb;
   	
     // Diffuse 
     vec3 norm = normalize(Normal);
-    vec3 lightDir = normalize(lightPos - FragPos);
+    vec3 lightDir = normalize(lightPos.xyz - FragPos);
     float diff = max(dot(norm, lightDir), 0.0);
-    vec3 diffuse = diff * lightColor;
+    vec3 diffuse = diff * lightColor.rgb;
             
-    vec3 result;
-    if (useTexture) {
-        vec4 texColor = texture(texture1, TexCoord);
-        result = (ambient + diffuse) * texColor.rgb;
-    } else {
-        result = (ambient + diffuse) * objectColor;
-    }
+    // selected at compile time by the material's shader variant
+#if defined(USE_VIRTUAL_TEXTURE)
+    vec3 result = (ambient + diffuse) * sampleVirtual(TexCoord).rgb;
+#elif defined(USE_TEXTURE_ARRAY)
+    // repeat inside the texture's rectangle of the layer; gradients come from
+    // the unwrapped coordinates so the fract() seam keeps the right mip
+    vec2 uv = UVRect.xy + fract(TexCoord) * UVRect.zw;
+    vec4 texColor = textureGrad(textureArray, vec3(uv, TextureLayer),
+                                dFdx(TexCoord) * UVRect.zw, dFdy(TexCoord) * UVRect.zw);
+    vec3 result = (ambient + diffuse) * texColor.rgb;
+#elif defined(USE_TEXTURE)
+    vec4 texColor = texture(texture1, TexCoord);
+    vec3 result = (ambient + diffuse) * texColor.rgb;
+#else
+    vec3 result = (ambient + diffuse) * objectColor.rgb;
+#endif
     
     FragColor = vec4(result, 1.0);
+    Velocity = (CurrentClip.xy / CurrentClip.w - PreviousClip.xy / PreviousClip.w) * 0.5;
 }
\ No newline at end of file
@@ -2,19 +2,59 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoord;
+// draw index of the instance, streamed by InstanceBuffer; 0 where not enabled
+layout (location = 3) in int aInstanceIndex;
 
 out vec2 TexCoord;
 out vec3 FragPos;
 out vec3 Normal;
+// unjittered clip positions this frame and last, for the velocity buffer
+out vec4 CurrentClip;
+out vec4 PreviousClip;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+#ifdef USE_TEXTURE_ARRAY
+flat out float TextureLayer;
+flat out vec4 UVRect;
+#endif
+
+// per-object data written by TransformBatch: world (4 texels), MVP (4 texels),
+// normal matrix (3 texels, layer in the first .w), texture rect and the
+// previous frame's MVP (4 texels) per draw index. Instanced draws add the
+// instance's index to drawIndex.
+uniform samplerBuffer transforms;
+uniform int drawIndex;
+
+layout (std140) uniform FrameData
+{
+    mat4 view;
+    mat4 projection;
+    vec4 lightPos;
+    vec4 lightColor;
+    vec4 objectColor;
+    vec4 jitter; // xy: NDC offset in this frame's MVPs
+};
 
 void main()
 {
+    int base = (drawIndex + aInstanceIndex) * 16;
+    mat4 model = mat4(texelFetch(transforms, base + 0), texelFetch(transforms, base + 1),
+                      texelFetch(transforms, base + 2), texelFetch(transforms, base + 3));
+    mat4 mvp = mat4(texelFetch(transforms, base + 4), texelFetch(transforms, base + 5),
+                    texelFetch(transforms, base + 6), texelFetch(transforms, base + 7));
+    mat3 normalMatrix = mat3(texelFetch(transforms, base + 8).xyz, texelFetch(transforms, base + 9).xyz,
+                             texelFetch(transforms, base + 10).xyz);
+
     FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNormal;
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    Normal = normalMatrix * aNormal;
+    gl_Position = mvp * vec4(aPos, 1.0);
+    mat4 previousMvp = mat4(texelFetch(transforms, base + 12), texelFetch(transforms, base + 13),
+                            texelFetch(transforms, base + 14), texelFetch(transforms, base + 15));
+    CurrentClip = gl_Position;
+    CurrentClip.xy -= jitter.xy * gl_Position.w;
+    PreviousClip = previousMvp * vec4(aPos, 1.0);
     TexCoord = aTexCoord;
+#ifdef USE_TEXTURE_ARRAY
+    TextureLayer = texelFetch(transforms, base + 8).w;
+    UVRect = texelFetch(transforms, base + 11);
+#endif
 }
\ No newline at end of file
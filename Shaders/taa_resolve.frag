@@ -0,0 +1,93 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+// see TemporalAA
+uniform sampler2D sceneColor;    // this frame, jittered, possibly below output resolution
+uniform sampler2D sceneVelocity; // UV motion since last frame
+uniform sampler2D sceneDepth;
+uniform sampler2D history;       // accumulated result of the previous frame, output resolution
+uniform bool historyValid;
+uniform vec2 jitter;             // this frame's offset in scene pixels
+uniform float blend;
+uniform float clipGamma;
+
+vec3 toYCoCg(vec3 c)
+{
+    return vec3(dot(c, vec3(0.25, 0.5, 0.25)), dot(c, vec3(0.5, 0.0, -0.5)), dot(c, vec3(-0.25, 0.5, -0.25)));
+}
+
+vec3 toRGB(vec3 c)
+{
+    return vec3(c.x + c.y - c.z, c.x + c.z, c.x - c.y - c.z);
+}
+
+// Moves history towards the centre of the box until it lies inside, which
+// keeps its hue better than clamping each channel
+vec3 clipToBox(vec3 value, vec3 boxMin, vec3 boxMax)
+{
+    vec3 center = 0.5 * (boxMax + boxMin);
+    vec3 extent = max(0.5 * (boxMax - boxMin), vec3(1e-4));
+    vec3 offset = value - center;
+    vec3 units = abs(offset / extent);
+    float largest = max(units.x, max(units.y, units.z));
+    return largest > 1.0 ? center + offset / largest : value;
+}
+
+void main()
+{
+    ivec2 sceneSize = textureSize(sceneColor, 0);
+    vec2 outputSize = vec2(textureSize(history, 0));
+    // the scene texel whose (jittered) sample landed nearest this output pixel
+    vec2 scenePosition = TexCoords * vec2(sceneSize);
+    ivec2 nearest = clamp(ivec2(floor(scenePosition + jitter)), ivec2(0), sceneSize - 1);
+
+    // colour moments of the 3x3 neighbourhood, and the nearest surface in it
+    vec3 sum = vec3(0.0), sumSquares = vec3(0.0);
+    vec3 current = vec3(0.0);
+    float closestDepth = 1.0;
+    ivec2 closest = nearest;
+    for (int y = -1; y <= 1; y++)
+    {
+        for (int x = -1; x <= 1; x++)
+        {
+            ivec2 texel = clamp(nearest + ivec2(x, y), ivec2(0), sceneSize - 1);
+            vec3 color = toYCoCg(texelFetch(sceneColor, texel, 0).rgb);
+            sum += color;
+            sumSquares += color * color;
+            if (x == 0 && y == 0)
+                current = color;
+            float depth = texelFetch(sceneDepth, texel, 0).r;
+            if (depth < closestDepth)
+            {
+                closestDepth = depth;
+                closest = texel;
+            }
+        }
+    }
+
+    vec2 historyUV = TexCoords - texelFetch(sceneVelocity, closest, 0).xy;
+    if (!historyValid || any(lessThan(historyUV, vec2(0.0))) || any(greaterThan(historyUV, vec2(1.0))))
+    {
+        // nothing to accumulate with: reconstruct this frame without its jitter
+        FragColor = vec4(max(texture(sceneColor, TexCoords + jitter / vec2(sceneSize)).rgb, 0.0), 1.0);
+        return;
+    }
+
+    vec3 mean = sum / 9.0;
+    vec3 deviation = sqrt(max(sumSquares / 9.0 - mean * mean, 0.0));
+    vec3 previous = toYCoCg(texture(history, historyUV).rgb);
+    previous = clipToBox(previous, mean - clipGamma * deviation, mean + clipGamma * deviation);
+
+    // the current sample counts for less the further it landed from this
+    // pixel's centre, measured in output pixels (Gaussian fit of Blackman-Harris)
+    vec2 offset = (vec2(nearest) + 0.5 - jitter - scenePosition) * outputSize / vec2(sceneSize);
+    float alpha = blend * exp(-2.29 * dot(offset, offset));
+
+    // weighting by inverse luma keeps single bright samples from flickering
+    float currentWeight = alpha / (1.0 + current.x);
+    float previousWeight = (1.0 - alpha) / (1.0 + previous.x);
+    vec3 result = (current * currentWeight + previous * previousWeight) / (currentWeight + previousWeight);
+    FragColor = vec4(max(toRGB(result), 0.0), 1.0);
+}
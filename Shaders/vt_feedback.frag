@@ -0,0 +1,21 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoord;
+
+// see VirtualTexture::setUniforms
+uniform vec4 vtLayout; // virtual size in texels, pages per side at mip 0, last mip, lod bias
+
+// Writes the virtual texture page (x, y, mip) this pixel samples, in the
+// same way as sampleVirtual in shader.frag; alpha 1 marks a request
+void main()
+{
+    vec2 dx = dFdx(TexCoord) * vtLayout.x;
+    vec2 dy = dFdy(TexCoord) * vtLayout.x;
+    float lod = 0.5 * log2(max(dot(dx, dx), dot(dy, dy))) + vtLayout.w;
+    float mip = clamp(floor(lod), 0.0, vtLayout.z);
+
+    float pages = max(floor(vtLayout.y / exp2(mip)), 1.0);
+    vec2 page = clamp(floor(TexCoord * pages), vec2(0.0), vec2(pages - 1.0));
+    FragColor = vec4(page, mip, 255.0) / 255.0;
+}
@@ -0,0 +1,83 @@
+#include "AutoExposure.h"
+#include "GLExtensions.h"
+#include "GLState.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+AutoExposure::AutoExposure()
+    : m_histogramBuffer(0) {
+    if (!GLExt::hasComputeShader)
+        return;
+    m_histogramShader = std::make_unique<Shader>("Shaders/luminance_histogram.comp");
+    m_averageShader = std::make_unique<Shader>("Shaders/luminance_average.comp");
+
+    // the bins, then the adapted luminance; negative makes the first frame snap to its average
+    std::vector<unsigned int> initial(BINS + 1, 0);
+    float unset = -1.0f;
+    memcpy(&initial[BINS], &unset, sizeof(unset));
+    glGenBuffers(1, &m_histogramBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_histogramBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, initial.size() * sizeof(unsigned int), initial.data(), GL_DYNAMIC_COPY);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+AutoExposure::~AutoExposure() {
+    glDeleteBuffers(1, &m_histogramBuffer);
+}
+
+FrameResource AutoExposure::addPass(FrameGraph& graph, FrameResource scene, const AutoExposureSettings& settings, float deltaTime) {
+    if (!settings.enabled || !isAvailable())
+        return NO_FRAME_RESOURCE;
+
+    RenderTargetDesc desc;
+    desc.format = GL_R32F;
+    desc.width = 1;
+    desc.height = 1;
+    FrameResource exposure = graph.createTexture("Exposure", desc);
+    graph.addPass("Auto exposure",
+        [&](FrameGraph::Builder& pass) {
+            pass.read(scene);
+            pass.writeStorage(exposure);
+        },
+        [this, &graph, scene, exposure, settings, deltaTime]() {
+            const RenderTargetDesc& sceneDesc = graph.getDesc(scene);
+            float logRange = std::max(settings.maxLogLuminance - settings.minLogLuminance, 0.01f);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_histogramBuffer);
+
+            m_histogramShader->use();
+            m_histogramShader->setInt("image"_u, 0);
+            m_histogramShader->setFloat("minLogLuminance"_u, settings.minLogLuminance);
+            m_histogramShader->setFloat("inverseLogLuminanceRange"_u, 1.0f / logRange);
+            GLState::activeTexture(GL_TEXTURE0);
+            GLState::bindTexture(GL_TEXTURE_2D, graph.getTexture(scene));
+            GLExt::DispatchCompute((sceneDesc.width + GROUP_SIZE - 1) / GROUP_SIZE, (sceneDesc.height + GROUP_SIZE - 1) / GROUP_SIZE, 1);
+            GLExt::MemBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+            m_averageShader->use();
+            m_averageShader->setFloat("pixelCount"_u, (float)sceneDesc.width * sceneDesc.height);
+            m_averageShader->setFloat("minLogLuminance"_u, settings.minLogLuminance);
+            m_averageShader->setFloat("logLuminanceRange"_u, logRange);
+            m_averageShader->setFloat("adaptation"_u, 1.0f - std::exp(-deltaTime * settings.adaptationSpeed));
+            m_averageShader->setFloat("key"_u, settings.key);
+            GLExt::BindImageTexture(0, graph.getTexture(exposure), 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+            GLExt::DispatchCompute(1, 1, 1);
+            // the post pass samples the exposure; next frame's histogram writes the buffer
+            GLExt::MemBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+        });
+    return exposure;
+}
+
+void AutoExposure::onFileChanged(const std::string& path) {
+    for (Shader* shader : { m_histogramShader.get(), m_averageShader.get() })
+        if (shader && shader->usesFile(path))
+            shader->beginReload();
+}
+
+void AutoExposure::pollReload() {
+    if (m_histogramShader)
+        m_histogramShader->pollReload();
+    if (m_averageShader)
+        m_averageShader->pollReload();
+}
@@ -0,0 +1,53 @@
+#ifndef AUTO_EXPOSURE_H
+#define AUTO_EXPOSURE_H
+
+#include <glad/glad.h>
+#include <memory>
+#include <string>
+#include "FrameGraph.h"
+#include "Shader.h"
+
+struct AutoExposureSettings {
+    bool enabled = true;
+    // log2 luminance range the histogram covers
+    float minLogLuminance = -8.0f;
+    float maxLogLuminance = 4.0f;
+    // the adapted average luminance is exposed to this
+    float key = 0.4f;
+    // how quickly the eye follows a change in brightness, per second
+    float adaptationSpeed = 1.5f;
+};
+
+// Exposure from the scene's own brightness, entirely on the GPU. A compute
+// pass bins the scene's log luminance into a histogram in a storage buffer,
+// a second reduces it to the average, eases the adapted luminance kept in
+// the same buffer towards it and writes the resulting exposure into a 1x1
+// texture the post pass samples. Nothing is ever read back to the CPU.
+// Needs compute shaders (GL 4.3).
+class AutoExposure {
+public:
+    AutoExposure();
+    ~AutoExposure();
+
+    AutoExposure(const AutoExposure&) = delete;
+    AutoExposure& operator=(const AutoExposure&) = delete;
+
+    bool isAvailable() const { return m_histogramShader != nullptr; }
+
+    // Adds the pass measuring scene and returns the R32F exposure it writes,
+    // or NO_FRAME_RESOURCE when disabled or unavailable
+    FrameResource addPass(FrameGraph& graph, FrameResource scene, const AutoExposureSettings& settings, float deltaTime);
+
+    void onFileChanged(const std::string& path);
+    void pollReload();
+
+private:
+    static const int BINS = 256;     // must match BINS in luminance_*.comp
+    static const int GROUP_SIZE = 16;
+
+    std::unique_ptr<Shader> m_histogramShader;
+    std::unique_ptr<Shader> m_averageShader;
+    unsigned int m_histogramBuffer;
+};
+
+#endif // AUTO_EXPOSURE_H
@@ -1,102 +1,191 @@
 #include "BloomEffect.h"
+#include "FullscreenQuad.h"
+#include "GLExtensions.h"
+#include "GLState.h"
+#include <algorithm>
+#include <cmath>
 
-BloomEffect::BloomEffect(int width, int height)
-    : m_width(width), m_height(height),
-    m_bloomShader("Shaders/bloom.vert", "Shaders/bloom.frag"),
-    m_blurShader("Shaders/blur.vert", "Shaders/blur.frag"),
-    m_finalShader("Shaders/final.vert", "Shaders/final.frag") {
-    setupFramebuffers();
+namespace {
+    // must match MAX_TAPS in bloom_blur.frag
+    const int MAX_LINEAR_TAPS = BloomEffect::MAX_BLUR_RADIUS / 2 + 1;
+    // and TILE in bloom_blur.comp
+    const int BLUR_TILE = 16;
 }
 
-BloomEffect::~BloomEffect() {
-    glDeleteFramebuffers(1, &m_hdrFBO);
-    glDeleteFramebuffers(2, m_pingpongFBO);
-    glDeleteTextures(2, m_colorBuffers);
-    glDeleteTextures(2, m_pingpongColorBuffers);
-    glDeleteVertexArrays(1, &m_quadVAO);
-    glDeleteBuffers(1, &m_quadVBO);
+BloomEffect::BloomEffect(int mipCount)
+    : m_maxMips(mipCount), m_mipCount(0),
+    m_downsampleShader("Shaders/fullscreen.vert", "Shaders/bloom_downsample.frag"),
+    m_upsampleShader("Shaders/fullscreen.vert", "Shaders/bloom_upsample.frag"),
+    m_blurShader("Shaders/fullscreen.vert", "Shaders/bloom_blur.frag"),
+    m_useComputeBlur(false), m_blurRadius(-1) {
+    if (GLExt::hasComputeShader) {
+        m_blurComputeShader = std::make_unique<Shader>("Shaders/bloom_blur.comp");
+        m_useComputeBlur = true;
+    }
 }
 
-void BloomEffect::setupFramebuffers() {
-    // Setup for HDR framebuffer
-    glGenFramebuffers(1, &m_hdrFBO);
-    glBindFramebuffer(GL_FRAMEBUFFER, m_hdrFBO);
-    glGenTextures(2, m_colorBuffers);
-    for (unsigned int i = 0; i < 2; i++) {
-        glBindTexture(GL_TEXTURE_2D, m_colorBuffers[i]);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, m_width, m_height, 0, GL_RGBA, GL_FLOAT, NULL);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, m_colorBuffers[i], 0);
+FrameResource BloomEffect::addPasses(FrameGraph& graph, FrameResource scene, const BloomSettings& settings) {
+    // level 0 is half the scene, each level half the one before. The levels
+    // only hold light, so R11G11B10 is enough and halves the bandwidth of RGBA16F.
+    std::vector<FrameResource> mips;
+    RenderTargetDesc desc;
+    desc.format = GL_R11F_G11F_B10F;
+    desc.width = graph.getDesc(scene).width;
+    desc.height = graph.getDesc(scene).height;
+    for (int i = 0; i < m_maxMips && desc.width > 1 && desc.height > 1; i++) {
+        desc.width = std::max(desc.width / 2, 1);
+        desc.height = std::max(desc.height / 2, 1);
+        mips.push_back(graph.createTexture("Bloom " + std::to_string(i), desc));
+    }
+    m_mipCount = (int)mips.size();
+
+    for (size_t i = 0; i < mips.size(); i++) {
+        FrameResource source = i == 0 ? scene : mips[i - 1];
+        FrameResource target = mips[i];
+        graph.addPass("Bloom downsample " + std::to_string(i),
+            [&](FrameGraph::Builder& pass) {
+                pass.read(source);
+                pass.writeColor(target);
+            },
+            [this, &graph, source, i, settings]() {
+                GLState::disable(GL_DEPTH_TEST);
+                GLState::disable(GL_BLEND);
+                GLState::polygonMode(GL_FRONT_AND_BACK, GL_FILL);
+                m_downsampleShader.use();
+                m_downsampleShader.setInt("image"_u, 0);
+                // the threshold is folded into the first pass rather than run at full resolution
+                m_downsampleShader.setBool("prefilter"_u, i == 0);
+                m_downsampleShader.setFloat("threshold"_u, settings.threshold);
+                m_downsampleShader.setFloat("knee"_u, settings.threshold * 0.5f);
+                GLState::activeTexture(GL_TEXTURE0);
+                GLState::bindTexture(GL_TEXTURE_2D, graph.getTexture(source));
+                drawFullscreenQuad();
+            });
     }
 
-    // Setup for ping-pong framebuffers
-    glGenFramebuffers(2, m_pingpongFBO);
-    glGenTextures(2, m_pingpongColorBuffers);
-    for (unsigned int i = 0; i < 2; i++) {
-        glBindFramebuffer(GL_FRAMEBUFFER, m_pingpongFBO[i]);
-        glBindTexture(GL_TEXTURE_2D, m_pingpongColorBuffers[i]);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, m_width, m_height, 0, GL_RGBA, GL_FLOAT, NULL);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_pingpongColorBuffers[i], 0);
+    for (size_t i = mips.size() - 1; i > 0 && i < mips.size(); i--) {
+        FrameResource source = mips[i];
+        FrameResource target = mips[i - 1];
+        graph.addPass("Bloom upsample " + std::to_string(i),
+            [&](FrameGraph::Builder& pass) {
+                pass.read(source);
+                // blended onto the downsampled contents
+                pass.read(target);
+                pass.writeColor(target);
+            },
+            [this, &graph, source, settings]() {
+                GLState::disable(GL_DEPTH_TEST);
+                GLState::enable(GL_BLEND);
+                GLState::blendFunc(GL_ONE, GL_ONE);
+                GLState::blendEquation(GL_FUNC_ADD);
+                GLState::polygonMode(GL_FRONT_AND_BACK, GL_FILL);
+                m_upsampleShader.use();
+                m_upsampleShader.setInt("image"_u, 0);
+                m_upsampleShader.setFloat("filterRadius"_u, settings.filterRadius);
+                GLState::activeTexture(GL_TEXTURE0);
+                GLState::bindTexture(GL_TEXTURE_2D, graph.getTexture(source));
+                drawFullscreenQuad();
+                GLState::disable(GL_BLEND);
+            });
     }
+
+    if (mips.empty())
+        return NO_FRAME_RESOURCE;
+    return addBlurPasses(graph, mips[0], std::min(settings.blurRadius, MAX_BLUR_RADIUS));
 }
 
-void BloomEffect::renderBloomTexture(unsigned int srcTexture, float threshold) {
-    m_bloomShader.use();
-    m_bloomShader.setFloat("threshold", threshold);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, srcTexture);
-    renderQuad();
+FrameResource BloomEffect::addBlurPasses(FrameGraph& graph, FrameResource bloom, int radius) {
+    if (radius <= 0)
+        return bloom;
+    if (radius != m_blurRadius)
+        computeBlurWeights(radius);
+
+    FrameResource scratch = graph.createTexture("Bloom blur", graph.getDesc(bloom));
+    if (m_useComputeBlur) {
+        // the dispatch writes the result once, so the first level is free afterwards
+        graph.addPass("Bloom blur (compute)",
+            [&](FrameGraph::Builder& pass) {
+                pass.read(bloom);
+                pass.writeStorage(scratch);
+            },
+            [this, &graph, bloom, scratch, radius]() {
+                const RenderTargetDesc& desc = graph.getDesc(scratch);
+                m_blurComputeShader->use();
+                m_blurComputeShader->setInt("image"_u, 0);
+                m_blurComputeShader->setInt("radius"_u, radius);
+                m_blurComputeShader->setFloatArray("weights"_u, m_blurWeights.data(), (int)m_blurWeights.size());
+                GLState::activeTexture(GL_TEXTURE0);
+                GLState::bindTexture(GL_TEXTURE_2D, graph.getTexture(bloom));
+                GLExt::BindImageTexture(0, graph.getTexture(scratch), 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R11F_G11F_B10F);
+                GLExt::DispatchCompute((desc.width + BLUR_TILE - 1) / BLUR_TILE, (desc.height + BLUR_TILE - 1) / BLUR_TILE, 1);
+                // later passes sample what the dispatch wrote
+                GLExt::MemBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+            });
+        return scratch;
+    }
+
+    // horizontally into the scratch target, vertically back into the first level
+    for (int vertical = 0; vertical < 2; vertical++) {
+        FrameResource source = vertical ? scratch : bloom;
+        FrameResource target = vertical ? bloom : scratch;
+        graph.addPass(vertical ? "Bloom blur vertical" : "Bloom blur horizontal",
+            [&](FrameGraph::Builder& pass) {
+                pass.read(source);
+                pass.writeColor(target);
+            },
+            [this, &graph, source, vertical]() {
+                GLState::disable(GL_DEPTH_TEST);
+                GLState::disable(GL_BLEND);
+                GLState::polygonMode(GL_FRONT_AND_BACK, GL_FILL);
+                m_blurShader.use();
+                m_blurShader.setInt("image"_u, 0);
+                m_blurShader.setInt("tapCount"_u, (int)m_linearWeights.size());
+                m_blurShader.setFloatArray("offsets"_u, m_linearOffsets.data(), (int)m_linearOffsets.size());
+                m_blurShader.setFloatArray("weights"_u, m_linearWeights.data(), (int)m_linearWeights.size());
+                m_blurShader.setVec2("direction"_u, vertical ? glm::vec2(0.0f, 1.0f) : glm::vec2(1.0f, 0.0f));
+                GLState::activeTexture(GL_TEXTURE0);
+                GLState::bindTexture(GL_TEXTURE_2D, graph.getTexture(source));
+                drawFullscreenQuad();
+            });
+    }
+    return bloom;
 }
 
-void BloomEffect::blurBloomTexture(int iterations) {
-    m_blurShader.use();
-    for (unsigned int i = 0; i < iterations; i++) {
-        glBindFramebuffer(GL_FRAMEBUFFER, m_pingpongFBO[i % 2]);
-        m_blurShader.setInt("horizontal", i % 2);
-        glBindTexture(GL_TEXTURE_2D, i == 0 ? m_colorBuffers[1] : m_pingpongColorBuffers[(i - 1) % 2]);
-        renderQuad();
+void BloomEffect::computeBlurWeights(int radius) {
+    // the kernel reaches out to about three standard deviations
+    float sigma = (radius + 1) / 3.0f;
+    m_blurWeights.assign(radius + 1, 0.0f);
+    float sum = 0.0f;
+    for (int i = 0; i <= radius; i++) {
+        m_blurWeights[i] = std::exp(-(float)(i * i) / (2.0f * sigma * sigma));
+        sum += i == 0 ? m_blurWeights[i] : 2.0f * m_blurWeights[i];
     }
+    for (float& weight : m_blurWeights)
+        weight /= sum;
+
+    // taps i and i + 1 become one fetch at their weighted mean offset, which
+    // bilinear filtering turns back into both with their own weights
+    m_linearOffsets.assign(1, 0.0f);
+    m_linearWeights.assign(1, m_blurWeights[0]);
+    for (int i = 1; i <= radius && (int)m_linearWeights.size() < MAX_LINEAR_TAPS; i += 2) {
+        float first = m_blurWeights[i];
+        float second = i + 1 <= radius ? m_blurWeights[i + 1] : 0.0f;
+        m_linearWeights.push_back(first + second);
+        m_linearOffsets.push_back((i * first + (i + 1) * second) / (first + second));
+    }
+    m_blurRadius = radius;
 }
 
-void BloomEffect::renderFinalImage(unsigned int srcTexture, float exposure) {
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    m_finalShader.use();
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, srcTexture);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, m_pingpongColorBuffers[1]);
-    m_finalShader.setInt("scene", 0);
-    m_finalShader.setInt("bloomBlur", 1);
-    m_finalShader.setFloat("exposure", exposure);
-    renderQuad();
+void BloomEffect::onFileChanged(const std::string& path) {
+    for (Shader* shader : { &m_downsampleShader, &m_upsampleShader, &m_blurShader, m_blurComputeShader.get() })
+        if (shader && shader->usesFile(path))
+            shader->beginReload();
 }
 
-void BloomEffect::renderQuad() {
-    if (m_quadVAO == 0) {
-        float quadVertices[] = {
-            -1.0f,  1.0f, 0.0f, 0.0f, 1.0f,
-            -1.0f, -1.0f, 0.0f, 0.0f, 0.0f,
-             1.0f,  1.0f, 0.0f, 1.0f, 1.0f,
-             1.0f, -1.0f, 0.0f, 1.0f, 0.0f,
-        };
-        glGenVertexArrays(1, &m_quadVAO);
-        glGenBuffers(1, &m_quadVBO);
-        glBindVertexArray(m_quadVAO);
-        glBindBuffer(GL_ARRAY_BUFFER, m_quadVBO);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
-    }
-    glBindVertexArray(m_quadVAO);
-    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-    glBindVertexArray(0);
+void BloomEffect::pollReload() {
+    m_downsampleShader.pollReload();
+    m_upsampleShader.pollReload();
+    m_blurShader.pollReload();
+    if (m_blurComputeShader)
+        m_blurComputeShader->pollReload();
 }
\ No newline at end of file
@@ -2,32 +2,68 @@
 #define BLOOM_EFFECT_H
 
 #include <glad/glad.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include "FrameGraph.h"
 #include "Shader.h"
 
+struct BloomSettings {
+    float threshold = 1.0f;
+    float filterRadius = 1.0f; // upsample tent width, in texels
+    int blurRadius = 0;        // Gaussian on the result, in texels; 0 skips it
+};
+
+// Bloom from a chain of progressively halved targets. The first downsample
+// thresholds the HDR scene into the first level and the rest keep halving
+// with a 13-tap filter; the upsample walks back up with a tent filter,
+// adding each level onto the next larger one. Every pass touches a quarter
+// of the pixels of the one before, so the whole effect costs about as much
+// as a couple of full-screen passes however wide the glow. The result is
+// optionally softened by a separable Gaussian, in one compute dispatch on
+// GL 4.3 or as two fragment passes otherwise. Each step is a frame graph
+// pass; PostProcess adds the result to the scene.
 class BloomEffect {
 public:
-    BloomEffect(int width, int height);
-    ~BloomEffect();
+    explicit BloomEffect(int mipCount = 6);
+
+    BloomEffect(const BloomEffect&) = delete;
+    BloomEffect& operator=(const BloomEffect&) = delete;
 
-    void setupFramebuffers();
-    void renderBloomTexture(unsigned int srcTexture, float threshold);
-    void blurBloomTexture(int iterations);
-    void renderFinalImage(unsigned int srcTexture, float exposure);
+    // Adds the passes that bloom scene and returns the half-resolution
+    // result, which holds the sum of every level
+    FrameResource addPasses(FrameGraph& graph, FrameResource scene, const BloomSettings& settings);
+    // Weight that brings the summed result back to scene brightness
+    float getCompositeScale() const { return m_mipCount > 0 ? 1.0f / m_mipCount : 0.0f; }
 
-    unsigned int getHdrFBO() const { return m_hdrFBO; }
-    unsigned int getColorBuffer(int index) const { return m_colorBuffers[index]; }
+    void onFileChanged(const std::string& path);
+    void pollReload();
+
+    int getMipCount() const { return m_mipCount; }
+
+    static const int MAX_BLUR_RADIUS = 16;
+    bool isComputeBlurAvailable() const { return m_blurComputeShader != nullptr; }
+    bool isComputeBlur() const { return m_useComputeBlur; }
+    void setComputeBlur(bool enabled) { m_useComputeBlur = enabled && isComputeBlurAvailable(); }
 
 private:
-    int m_width, m_height;
-    unsigned int m_hdrFBO, m_colorBuffers[2];
-    unsigned int m_pingpongFBO[2], m_pingpongColorBuffers[2];
-    unsigned int m_quadVAO, m_quadVBO;
+    int m_maxMips;
+    int m_mipCount;
 
-    Shader m_bloomShader;
+    Shader m_downsampleShader;
+    Shader m_upsampleShader;
     Shader m_blurShader;
-    Shader m_finalShader;
+    std::unique_ptr<Shader> m_blurComputeShader;
+    bool m_useComputeBlur;
+
+    // Gaussian weights of every tap out to the radius, and the same merged
+    // pairwise into bilinear fetches for the fragment path
+    int m_blurRadius;
+    std::vector<float> m_blurWeights;
+    std::vector<float> m_linearOffsets, m_linearWeights;
 
-    void renderQuad();
+    FrameResource addBlurPasses(FrameGraph& graph, FrameResource bloom, int radius);
+    void computeBlurWeights(int radius);
 };
 
 #endif // BLOOM_EFFECT_H
\ No newline at end of file
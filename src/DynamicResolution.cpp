@@ -0,0 +1,46 @@
+#include "DynamicResolution.h"
+#include <algorithm>
+#include <cmath>
+
+DynamicResolution::DynamicResolution()
+    : m_Scale(1.0f), m_Cooldown(0), m_ScaleChanges(0)
+{
+}
+
+void DynamicResolution::update(double gpuMilliseconds, const DynamicResolutionSettings& settings)
+{
+    float minScale = std::min(settings.minScale, settings.maxScale);
+    float scale = m_Scale;
+    if (!settings.enabled)
+    {
+        scale = settings.maxScale;
+    }
+    else if (m_Cooldown > 0)
+    {
+        m_Cooldown--;
+    }
+    else if (gpuMilliseconds > 0.0)
+    {
+        float budget = settings.targetMilliseconds;
+        if (gpuMilliseconds > budget || gpuMilliseconds < budget * HEADROOM)
+        {
+            // aim for the middle of the band the scale is left alone in
+            float wanted = m_Scale * std::sqrt(budget * (1.0f + HEADROOM) * 0.5f / (float)gpuMilliseconds);
+            wanted = std::min(std::max(wanted, m_Scale - MAX_CHANGE), m_Scale + MAX_CHANGE);
+            scale = std::round(wanted / SCALE_STEP) * SCALE_STEP;
+        }
+    }
+    scale = std::min(std::max(scale, minScale), settings.maxScale);
+
+    if (scale != m_Scale)
+    {
+        m_Scale = scale;
+        m_Cooldown = SETTLE_FRAMES;
+        m_ScaleChanges++;
+    }
+}
+
+int DynamicResolution::scaled(int size) const
+{
+    return std::max((int)std::lround(size * m_Scale), 1);
+}
@@ -0,0 +1,44 @@
+#ifndef DYNAMIC_RESOLUTION_H
+#define DYNAMIC_RESOLUTION_H
+
+struct DynamicResolutionSettings {
+    bool enabled = true;
+    float targetMilliseconds = 14.0f; // GPU time the frame should take
+    float minScale = 0.5f;
+    float maxScale = 1.0f;
+};
+
+// Picks the fraction of the window size the scene is rendered at so the
+// measured GPU frame time stays just under the target. Cost is taken to be
+// proportional to the pixel count, i.e. to the scale squared. The scale
+// moves in coarse steps, so the render target pool reuses targets rather
+// than reallocating every frame, and after each step it waits for the
+// timings of the new size to come in before judging again; inside a band
+// below the target it holds still.
+class DynamicResolution {
+public:
+    DynamicResolution();
+
+    // Once per frame with the latest GPU time of the frame; 0 or less if
+    // none has been measured yet
+    void update(double gpuMilliseconds, const DynamicResolutionSettings& settings);
+
+    float getScale() const { return m_Scale; }
+    // size * scale, at least one pixel
+    int scaled(int size) const;
+    int getScaleChanges() const { return m_ScaleChanges; }
+
+private:
+    static constexpr float SCALE_STEP = 0.05f;
+    static constexpr float MAX_CHANGE = 0.15f;
+    // the scale only grows while the frame is this far under the target
+    static constexpr float HEADROOM = 0.85f;
+    // GpuTimer results are a few frames late and smoothed over about ten
+    static const int SETTLE_FRAMES = 15;
+
+    float m_Scale;
+    int m_Cooldown;
+    int m_ScaleChanges;
+};
+
+#endif // DYNAMIC_RESOLUTION_H
@@ -0,0 +1,112 @@
+#include "FileWatcher.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <map>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+FileWatcher::FileWatcher(const std::string& directory)
+    : m_Directory(directory), m_Running(true)
+{
+    m_Thread = std::thread(&FileWatcher::run, this);
+}
+
+FileWatcher::~FileWatcher()
+{
+    m_Running = false;
+    if (m_Thread.joinable())
+        m_Thread.join();
+}
+
+std::vector<std::string> FileWatcher::pollChanges()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    std::vector<std::string> changed;
+    changed.swap(m_Changed);
+    return changed;
+}
+
+void FileWatcher::pushChange(const std::string& name)
+{
+    std::string path = m_Directory + "/" + name;
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    // editors often write a file several times in a row; report it once
+    if (std::find(m_Changed.begin(), m_Changed.end(), path) == m_Changed.end())
+        m_Changed.push_back(path);
+}
+
+#ifdef __linux__
+
+void FileWatcher::run()
+{
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0 || inotify_add_watch(fd, m_Directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0)
+    {
+        std::cout << "FileWatcher: cannot watch " << m_Directory << std::endl;
+        if (fd >= 0)
+            close(fd);
+        return;
+    }
+
+    alignas(inotify_event) char buffer[4096];
+    while (m_Running)
+    {
+        // wake up regularly so the destructor does not wait long
+        pollfd pfd = { fd, POLLIN, 0 };
+        if (poll(&pfd, 1, 200) <= 0)
+            continue;
+
+        ssize_t length = read(fd, buffer, sizeof(buffer));
+        for (ssize_t offset = 0; offset < length; )
+        {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            if (event->len > 0 && !(event->mask & IN_ISDIR))
+                pushChange(event->name);
+            offset += sizeof(inotify_event) + event->len;
+        }
+    }
+    close(fd);
+}
+
+#else
+
+void FileWatcher::run()
+{
+    namespace fs = std::filesystem;
+    std::map<std::string, fs::file_time_type> lastWrite;
+    bool firstScan = true;
+
+    while (m_Running)
+    {
+        std::error_code ec;
+        for (const auto& entry : fs::directory_iterator(m_Directory, ec))
+        {
+            if (!entry.is_regular_file(ec))
+                continue;
+            std::string name = entry.path().filename().string();
+            fs::file_time_type time = entry.last_write_time(ec);
+            auto it = lastWrite.find(name);
+            if (it == lastWrite.end())
+            {
+                lastWrite[name] = time;
+                if (!firstScan)
+                    pushChange(name);
+            }
+            else if (it->second != time)
+            {
+                it->second = time;
+                pushChange(name);
+            }
+        }
+        firstScan = false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    }
+}
+
+#endif
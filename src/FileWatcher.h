@@ -0,0 +1,35 @@
+#ifndef FILE_WATCHER_H
+#define FILE_WATCHER_H
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Watches one directory on a background thread and queues the paths of
+// files that were written. Uses inotify on Linux and falls back to polling
+// modification times elsewhere.
+class FileWatcher {
+public:
+    FileWatcher(const std::string& directory);
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    // Returns (and clears) the files changed since the last call, as "directory/name"
+    std::vector<std::string> pollChanges();
+
+private:
+    std::string m_Directory;
+    std::thread m_Thread;
+    std::atomic<bool> m_Running;
+    std::mutex m_Mutex;
+    std::vector<std::string> m_Changed;
+
+    void run();
+    void pushChange(const std::string& name);
+};
+
+#endif // FILE_WATCHER_H
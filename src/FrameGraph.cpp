@@ -0,0 +1,337 @@
+#include "FrameGraph.h"
+#include "GLState.h"
+#include <algorithm>
+#include <cstdio>
+#include <queue>
+
+namespace {
+    void addUnique(std::vector<int>& list, int value)
+    {
+        if (value >= 0 && std::find(list.begin(), list.end(), value) == list.end())
+            list.push_back(value);
+    }
+}
+
+void FrameGraph::Builder::read(FrameResource resource)
+{
+    Resource& entry = m_Graph->m_Resources[resource];
+    Pass& pass = m_Graph->m_Passes[m_Pass];
+    addUnique(pass.reads, resource);
+    if (entry.lastWriter != m_Pass)
+    {
+        addUnique(pass.producers, entry.lastWriter);
+        addUnique(pass.after, entry.lastWriter);
+    }
+    addUnique(entry.readersSinceWrite, m_Pass);
+}
+
+void FrameGraph::Builder::write(FrameResource resource)
+{
+    Resource& entry = m_Graph->m_Resources[resource];
+    Pass& pass = m_Graph->m_Passes[m_Pass];
+    addUnique(pass.writes, resource);
+    if (entry.lastWriter == m_Pass)
+        return;
+
+    // runs after the previous writer and after everyone who read its result
+    addUnique(pass.after, entry.lastWriter);
+    for (int reader : entry.readersSinceWrite)
+        if (reader != m_Pass)
+            addUnique(pass.after, reader);
+    entry.lastWriter = m_Pass;
+    entry.readersSinceWrite.clear();
+    if (entry.backbuffer || entry.imported)
+        pass.sideEffect = true;
+}
+
+void FrameGraph::Builder::writeColor(FrameResource resource, bool clear, const glm::vec4& clearColor)
+{
+    Pass& pass = m_Graph->m_Passes[m_Pass];
+    pass.colors.push_back({ resource, clear, clearColor });
+    write(resource);
+}
+
+void FrameGraph::Builder::writeDepth(FrameResource resource, bool clear)
+{
+    Pass& pass = m_Graph->m_Passes[m_Pass];
+    pass.depth = resource;
+    pass.clearDepth = clear;
+    write(resource);
+}
+
+void FrameGraph::Builder::writeStorage(FrameResource resource)
+{
+    write(resource);
+}
+
+void FrameGraph::Builder::setSideEffect()
+{
+    m_Graph->m_Passes[m_Pass].sideEffect = true;
+}
+
+FrameGraph::FrameGraph(RenderTargetPool& pool)
+    : m_Pool(pool), m_Backbuffer(NO_FRAME_RESOURCE), m_ExecutedPasses(0), m_CulledPasses(0), m_GpuMilliseconds(0.0)
+{
+}
+
+FrameResource FrameGraph::createTexture(const std::string& name, const RenderTargetDesc& desc)
+{
+    Resource resource;
+    resource.name = name;
+    resource.desc = desc;
+    m_Resources.push_back(resource);
+    return (FrameResource)m_Resources.size() - 1;
+}
+
+FrameResource FrameGraph::getBackbuffer()
+{
+    if (m_Backbuffer == NO_FRAME_RESOURCE)
+    {
+        RenderTargetDesc desc;
+        desc.width = m_Pool.getScreenWidth();
+        desc.height = m_Pool.getScreenHeight();
+        m_Backbuffer = createTexture("Backbuffer", desc);
+        m_Resources[m_Backbuffer].backbuffer = true;
+    }
+    return m_Backbuffer;
+}
+
+FrameResource FrameGraph::importTexture(const std::string& name, const RenderTarget* target)
+{
+    FrameResource resource = createTexture(name, target->desc);
+    m_Resources[resource].imported = true;
+    m_Resources[resource].target = target;
+    return resource;
+}
+
+void FrameGraph::addPass(const std::string& name, const std::function<void(Builder&)>& setup, std::function<void()> execute)
+{
+    Pass pass;
+    pass.name = name;
+    pass.execute = std::move(execute);
+    m_Passes.push_back(std::move(pass));
+    Builder builder(this, (int)m_Passes.size() - 1);
+    setup(builder);
+}
+
+unsigned int FrameGraph::getTexture(FrameResource resource) const
+{
+    if (resource < 0 || resource >= (int)m_Resources.size() || !m_Resources[resource].target)
+        return 0;
+    return m_Resources[resource].target->texture;
+}
+
+double FrameGraph::getPassMilliseconds(const std::string& name) const
+{
+    auto it = m_Timers.find(name);
+    if (it == m_Timers.end() || !it->second->hasResult())
+        return -1.0;
+    return it->second->getMilliseconds();
+}
+
+void FrameGraph::cull()
+{
+    // keep what the side effects need, walking back through what each kept pass reads
+    std::vector<int> pending;
+    for (int i = 0; i < (int)m_Passes.size(); i++)
+    {
+        if (m_Passes[i].sideEffect)
+        {
+            m_Passes[i].kept = true;
+            pending.push_back(i);
+        }
+    }
+    while (!pending.empty())
+    {
+        int pass = pending.back();
+        pending.pop_back();
+        for (int producer : m_Passes[pass].producers)
+        {
+            if (!m_Passes[producer].kept)
+            {
+                m_Passes[producer].kept = true;
+                pending.push_back(producer);
+            }
+        }
+    }
+}
+
+std::vector<int> FrameGraph::order() const
+{
+    // Kahn's algorithm over the kept passes, ties going to the pass added first
+    std::vector<int> waitingOn(m_Passes.size(), 0);
+    std::vector<std::vector<int>> unblocks(m_Passes.size());
+    for (int i = 0; i < (int)m_Passes.size(); i++)
+    {
+        if (!m_Passes[i].kept)
+            continue;
+        for (int before : m_Passes[i].after)
+        {
+            if (!m_Passes[before].kept)
+                continue;
+            waitingOn[i]++;
+            unblocks[before].push_back(i);
+        }
+    }
+
+    std::priority_queue<int, std::vector<int>, std::greater<int>> ready;
+    for (int i = 0; i < (int)m_Passes.size(); i++)
+        if (m_Passes[i].kept && waitingOn[i] == 0)
+            ready.push(i);
+
+    std::vector<int> result;
+    while (!ready.empty())
+    {
+        int pass = ready.top();
+        ready.pop();
+        result.push_back(pass);
+        for (int next : unblocks[pass])
+            if (--waitingOn[next] == 0)
+                ready.push(next);
+    }
+    return result;
+}
+
+void FrameGraph::bindAttachments(const Pass& pass)
+{
+    if (pass.colors.empty() && pass.depth == NO_FRAME_RESOURCE)
+        return;
+
+    const Resource* depth = pass.depth != NO_FRAME_RESOURCE ? &m_Resources[pass.depth] : nullptr;
+    const RenderTargetDesc& size = !pass.colors.empty() ? m_Resources[pass.colors[0].resource].desc : depth->desc;
+    if (!pass.colors.empty() && m_Resources[pass.colors[0].resource].backbuffer)
+    {
+        GLState::bindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+    else
+    {
+        std::vector<const RenderTarget*> colors;
+        for (const ColorAttachment& color : pass.colors)
+            colors.push_back(m_Resources[color.resource].target);
+        GLState::bindFramebuffer(GL_FRAMEBUFFER, m_Pool.getFramebuffer(colors, depth ? depth->target : nullptr));
+    }
+    glViewport(0, 0, size.width, size.height);
+
+    for (int i = 0; i < (int)pass.colors.size(); i++)
+        if (pass.colors[i].clear)
+            glClearBufferfv(GL_COLOR, i, &pass.colors[i].clearValue[0]);
+    if (pass.clearDepth)
+    {
+        GLState::depthMask(GL_TRUE);
+        glClear(GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+    }
+}
+
+void FrameGraph::execute()
+{
+    cull();
+    std::vector<int> executionOrder = order();
+
+    for (int position = 0; position < (int)executionOrder.size(); position++)
+    {
+        const Pass& pass = m_Passes[executionOrder[position]];
+        for (const std::vector<FrameResource>* list : { &pass.reads, &pass.writes })
+        {
+            for (FrameResource resource : *list)
+            {
+                Resource& entry = m_Resources[resource];
+                if (entry.firstUse < 0)
+                    entry.firstUse = position;
+                entry.lastUse = position;
+            }
+        }
+    }
+
+    for (int position = 0; position < (int)executionOrder.size(); position++)
+    {
+        Pass& pass = m_Passes[executionOrder[position]];
+        for (FrameResource resource : pass.writes)
+        {
+            Resource& entry = m_Resources[resource];
+            if (entry.firstUse == position && !entry.backbuffer && !entry.imported)
+                entry.target = m_Pool.acquire(entry.desc);
+        }
+
+        std::unique_ptr<GpuTimer>& timer = m_Timers[pass.name];
+        if (!timer)
+            timer = std::make_unique<GpuTimer>();
+        timer->begin();
+        bindAttachments(pass);
+        pass.execute();
+        timer->end();
+
+        // textures nobody reads after this pass can be handed to the next one
+        for (const std::vector<FrameResource>* list : { &pass.reads, &pass.writes })
+        {
+            for (FrameResource resource : *list)
+            {
+                Resource& entry = m_Resources[resource];
+                if (entry.lastUse == position && entry.target && !entry.imported)
+                {
+                    m_Pool.release(entry.target);
+                    entry.target = nullptr;
+                }
+            }
+        }
+    }
+
+    buildDump(executionOrder);
+    m_Passes.clear();
+    m_Resources.clear();
+    m_Backbuffer = NO_FRAME_RESOURCE;
+}
+
+void FrameGraph::buildDump(const std::vector<int>& executionOrder)
+{
+    m_ExecutedPasses = (int)executionOrder.size();
+    m_CulledPasses = (int)m_Passes.size() - m_ExecutedPasses;
+
+    char line[256];
+    m_Dump.clear();
+    double total = 0.0;
+    auto describe = [&](const Pass& pass, const char* prefix) {
+        const GpuTimer* timer = m_Timers.count(pass.name) ? m_Timers[pass.name].get() : nullptr;
+        if (timer && pass.kept)
+        {
+            snprintf(line, sizeof(line), "%s%-28s %7.3f ms\n", prefix, pass.name.c_str(), timer->getMilliseconds());
+            total += timer->getMilliseconds();
+        }
+        else
+        {
+            snprintf(line, sizeof(line), "%s%-28s  culled\n", prefix, pass.name.c_str());
+        }
+        m_Dump += line;
+        std::string resources;
+        for (FrameResource resource : pass.reads)
+            resources += (resources.empty() ? "" : ", ") + m_Resources[resource].name;
+        if (!resources.empty())
+            m_Dump += "      reads  " + resources + "\n";
+        resources.clear();
+        for (FrameResource resource : pass.writes)
+            resources += (resources.empty() ? "" : ", ") + m_Resources[resource].name;
+        if (!resources.empty())
+            m_Dump += "      writes " + resources + "\n";
+    };
+
+    for (int position = 0; position < (int)executionOrder.size(); position++)
+    {
+        char prefix[16];
+        snprintf(prefix, sizeof(prefix), "%2d ", position);
+        describe(m_Passes[executionOrder[position]], prefix);
+    }
+    for (const Pass& pass : m_Passes)
+        if (!pass.kept)
+            describe(pass, " - ");
+
+    m_GpuMilliseconds = total;
+    snprintf(line, sizeof(line), "%d passes, %d culled, %.3f ms\n", m_ExecutedPasses, m_CulledPasses, total);
+    m_Dump += line;
+    for (const Resource& resource : m_Resources)
+    {
+        if (resource.backbuffer || resource.firstUse < 0)
+            continue;
+        snprintf(line, sizeof(line), "  %-24s %5dx%-5d passes %d-%d\n", resource.name.c_str(),
+            resource.desc.width, resource.desc.height, resource.firstUse, resource.lastUse);
+        m_Dump += line;
+    }
+}
@@ -0,0 +1,134 @@
+#ifndef FRAME_GRAPH_H
+#define FRAME_GRAPH_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "GpuTimer.h"
+#include "RenderTargetPool.h"
+
+// Handle to a texture for the frame being built; -1 is none
+typedef int FrameResource;
+const FrameResource NO_FRAME_RESOURCE = -1;
+
+// The frame as a list of passes that declare the textures they read and
+// write, rebuilt every frame. execute() orders the passes by those
+// dependencies, drops passes nothing needed reads from, takes each
+// transient texture from the render target pool just before its first use
+// and gives it back right after its last, so textures with disjoint
+// lifetimes share memory, and binds each pass's attachments (clearing them
+// if asked) before running it. Textures that outlive the frame, such as
+// history kept across frames, are imported; the graph orders their uses
+// but never allocates or releases them. Every pass is timed on the GPU;
+// dump() describes the last executed frame.
+class FrameGraph {
+public:
+    class Builder {
+    public:
+        // Sampled by the pass
+        void read(FrameResource resource);
+        // Rendered to; the graph binds the framebuffer and a viewport covering
+        // it. A pass blending onto earlier contents must read it as well.
+        // Several colour writes become draw buffers 0, 1, ... in the order
+        // they are declared.
+        void writeColor(FrameResource resource, bool clear = false, const glm::vec4& clearColor = glm::vec4(0.0f));
+        void writeDepth(FrameResource resource, bool clear = false);
+        // Written without an attachment, e.g. by image stores
+        void writeStorage(FrameResource resource);
+        // Keeps the pass even though no kept pass reads what it writes,
+        // e.g. when it reads results back to the CPU
+        void setSideEffect();
+
+    private:
+        friend class FrameGraph;
+        FrameGraph* m_Graph;
+        int m_Pass;
+        Builder(FrameGraph* graph, int pass) : m_Graph(graph), m_Pass(pass) {}
+        void write(FrameResource resource);
+    };
+
+    explicit FrameGraph(RenderTargetPool& pool);
+
+    FrameGraph(const FrameGraph&) = delete;
+    FrameGraph& operator=(const FrameGraph&) = delete;
+
+    // A texture that only lives within this frame
+    FrameResource createTexture(const std::string& name, const RenderTargetDesc& desc);
+    // The window's default framebuffer; passes writing it are always kept
+    FrameResource getBackbuffer();
+    // A texture owned elsewhere that lives across frames; passes writing it
+    // are always kept
+    FrameResource importTexture(const std::string& name, const RenderTarget* target);
+
+    void addPass(const std::string& name, const std::function<void(Builder&)>& setup, std::function<void()> execute);
+
+    // Runs the frame and clears the graph for the next one
+    void execute();
+
+    // Valid while a pass that declared the resource executes
+    unsigned int getTexture(FrameResource resource) const;
+    const RenderTargetDesc& getDesc(FrameResource resource) const { return m_Resources[resource].desc; }
+
+    // The passes of the last executed frame in order, with their resources
+    // and timings, culled passes last
+    const std::string& dump() const { return m_Dump; }
+    // Smoothed GPU time of the named pass whenever it last ran; negative if it never did
+    double getPassMilliseconds(const std::string& name) const;
+    // Sum of the above over the passes of the last executed frame
+    double getGpuMilliseconds() const { return m_GpuMilliseconds; }
+    int getExecutedPasses() const { return m_ExecutedPasses; }
+    int getCulledPasses() const { return m_CulledPasses; }
+
+private:
+    struct Resource {
+        std::string name;
+        RenderTargetDesc desc;
+        bool backbuffer = false;
+        bool imported = false;
+        const RenderTarget* target = nullptr;
+        // while passes are added: the last writer and the readers since
+        int lastWriter = -1;
+        std::vector<int> readersSinceWrite;
+        // first and last position in the execution order
+        int firstUse = -1, lastUse = -1;
+    };
+
+    struct ColorAttachment {
+        FrameResource resource;
+        bool clear;
+        glm::vec4 clearValue;
+    };
+
+    struct Pass {
+        std::string name;
+        std::function<void()> execute;
+        std::vector<FrameResource> reads, writes;
+        std::vector<ColorAttachment> colors;
+        FrameResource depth = NO_FRAME_RESOURCE;
+        bool clearDepth = false;
+        bool sideEffect = false;
+        // passes whose results this one reads, and passes that must run first
+        std::vector<int> producers, after;
+        bool kept = false;
+    };
+
+    RenderTargetPool& m_Pool;
+    std::vector<Resource> m_Resources;
+    std::vector<Pass> m_Passes;
+    FrameResource m_Backbuffer;
+    std::map<std::string, std::unique_ptr<GpuTimer>> m_Timers;
+    std::string m_Dump;
+    int m_ExecutedPasses, m_CulledPasses;
+    double m_GpuMilliseconds;
+
+    void cull();
+    std::vector<int> order() const;
+    void bindAttachments(const Pass& pass);
+    void buildDump(const std::vector<int>& executionOrder);
+};
+
+#endif // FRAME_GRAPH_H
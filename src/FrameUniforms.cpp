@@ -0,0 +1,66 @@
+#include "FrameUniforms.h"
+#include <cstring>
+
+FrameUniforms::FrameUniforms(int ringSize)
+    : m_UBO(0), m_SlotSize(0), m_RingSize(ringSize), m_CurrentSlot(0)
+{
+    if (m_RingSize < 1)
+        m_RingSize = 1;
+    if (m_RingSize > 8)
+        m_RingSize = 8;
+    for (int i = 0; i < 8; i++)
+        m_Fences[i] = 0;
+
+    // each slot has to start on the driver's uniform buffer offset alignment
+    int alignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    m_SlotSize = ((int)sizeof(FrameData) + alignment - 1) / alignment * alignment;
+
+    glGenBuffers(1, &m_UBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_UBO);
+    glBufferData(GL_UNIFORM_BUFFER, m_SlotSize * m_RingSize, NULL, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+FrameUniforms::~FrameUniforms()
+{
+    for (int i = 0; i < m_RingSize; i++)
+    {
+        if (m_Fences[i])
+            glDeleteSync(m_Fences[i]);
+    }
+    glDeleteBuffers(1, &m_UBO);
+}
+
+void FrameUniforms::update(const FrameData& data)
+{
+    m_CurrentSlot = (m_CurrentSlot + 1) % m_RingSize;
+    GLintptr offset = (GLintptr)m_CurrentSlot * m_SlotSize;
+
+    // the GPU may still be reading this slot from m_RingSize frames ago
+    if (m_Fences[m_CurrentSlot])
+    {
+        glClientWaitSync(m_Fences[m_CurrentSlot], GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        glDeleteSync(m_Fences[m_CurrentSlot]);
+        m_Fences[m_CurrentSlot] = 0;
+    }
+
+    glBindBuffer(GL_UNIFORM_BUFFER, m_UBO);
+    void* ptr = glMapBufferRange(GL_UNIFORM_BUFFER, offset, sizeof(FrameData),
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (ptr)
+    {
+        memcpy(ptr, &data, sizeof(FrameData));
+        glUnmapBuffer(GL_UNIFORM_BUFFER);
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    glBindBufferRange(GL_UNIFORM_BUFFER, FRAME_DATA_BINDING, m_UBO, offset, sizeof(FrameData));
+}
+
+void FrameUniforms::endFrame()
+{
+    if (m_Fences[m_CurrentSlot])
+        glDeleteSync(m_Fences[m_CurrentSlot]);
+    m_Fences[m_CurrentSlot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
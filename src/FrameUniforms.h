@@ -0,0 +1,40 @@
+#ifndef FRAME_UNIFORMS_H
+#define FRAME_UNIFORMS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+// Uniform block binding point shared by every program that declares FrameData
+const unsigned int FRAME_DATA_BINDING = 0;
+
+// CPU mirror of the std140 FrameData block in the shaders; vec3 values are
+// padded to vec4 so the layout matches without manual offsets
+struct FrameData {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::vec4 lightPos;
+    glm::vec4 lightColor;
+    glm::vec4 objectColor;
+    glm::vec4 jitter; // xy: NDC offset in this frame's MVPs (TemporalAA)
+};
+
+class FrameUniforms {
+public:
+    FrameUniforms(int ringSize = 3);
+    ~FrameUniforms();
+
+    // Writes the next ring slot and binds it to FRAME_DATA_BINDING
+    void update(const FrameData& data);
+    // Call after the frame's draws are submitted so the slot is not
+    // overwritten while the GPU still reads it
+    void endFrame();
+
+private:
+    unsigned int m_UBO;
+    int m_SlotSize;
+    int m_RingSize;
+    int m_CurrentSlot;
+    GLsync m_Fences[8];
+};
+
+#endif // FRAME_UNIFORMS_H
@@ -0,0 +1,9 @@
+#ifndef FULLSCREEN_QUAD_H
+#define FULLSCREEN_QUAD_H
+
+// Draws the quad covering the viewport that every full-screen pass uses,
+// positions at attribute 0 and texture coordinates at 1 (fullscreen.vert).
+// The vertex array is created on first use and shared by all passes.
+void drawFullscreenQuad();
+
+#endif // FULLSCREEN_QUAD_H
@@ -0,0 +1,97 @@
+#include "GLExtensions.h"
+#include <cstring>
+
+namespace GLExt {
+    bool hasProgramBinary = false;
+    PFNGLGETPROGRAMBINARYEXTPROC GetProgramBinary = nullptr;
+    PFNGLPROGRAMBINARYEXTPROC ProgramBinary = nullptr;
+    PFNGLPROGRAMPARAMETERIEXTPROC ProgramParameteri = nullptr;
+
+    bool hasParallelShaderCompile = false;
+    PFNGLMAXSHADERCOMPILERTHREADSEXTPROC MaxShaderCompilerThreads = nullptr;
+
+    bool hasAnisotropicFiltering = false;
+    float maxAnisotropy = 1.0f;
+
+    bool hasBufferStorage = false;
+    PFNGLBUFFERSTORAGEEXTPROC BufferStorage = nullptr;
+
+    bool hasTextureCompressionS3TC = false;
+    bool hasTextureCompressionBPTC = false;
+
+    bool hasComputeShader = false;
+    int maxComputeSharedMemory = 0;
+    PFNGLDISPATCHCOMPUTEEXTPROC DispatchCompute = nullptr;
+    PFNGLBINDIMAGETEXTUREEXTPROC BindImageTexture = nullptr;
+    PFNGLMEMORYBARRIEREXTPROC MemBarrier = nullptr;
+}
+
+bool hasGLVersion(int major, int minor)
+{
+    return GLVersion.major > major || (GLVersion.major == major && GLVersion.minor >= minor);
+}
+
+bool hasGLExtension(const char* name)
+{
+    int count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (int i = 0; i < count; i++)
+    {
+        const char* ext = (const char*)glGetStringi(GL_EXTENSIONS, i);
+        if (ext && strcmp(ext, name) == 0)
+            return true;
+    }
+    return false;
+}
+
+void loadGLExtensions(GLADloadproc load)
+{
+    using namespace GLExt;
+
+    if (hasGLVersion(4, 1) || hasGLExtension("GL_ARB_get_program_binary"))
+    {
+        GetProgramBinary = (PFNGLGETPROGRAMBINARYEXTPROC)load("glGetProgramBinary");
+        ProgramBinary = (PFNGLPROGRAMBINARYEXTPROC)load("glProgramBinary");
+        ProgramParameteri = (PFNGLPROGRAMPARAMETERIEXTPROC)load("glProgramParameteri");
+
+        int formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        hasProgramBinary = GetProgramBinary && ProgramBinary && ProgramParameteri && formats > 0;
+    }
+
+    if (hasGLExtension("GL_KHR_parallel_shader_compile"))
+        MaxShaderCompilerThreads = (PFNGLMAXSHADERCOMPILERTHREADSEXTPROC)load("glMaxShaderCompilerThreadsKHR");
+    else if (hasGLExtension("GL_ARB_parallel_shader_compile"))
+        MaxShaderCompilerThreads = (PFNGLMAXSHADERCOMPILERTHREADSEXTPROC)load("glMaxShaderCompilerThreadsARB");
+    if (MaxShaderCompilerThreads)
+    {
+        // let the driver pick how many compiler threads to use
+        MaxShaderCompilerThreads(0xFFFFFFFF);
+        hasParallelShaderCompile = true;
+    }
+
+    if (hasGLVersion(4, 6) || hasGLExtension("GL_EXT_texture_filter_anisotropic") || hasGLExtension("GL_ARB_texture_filter_anisotropic"))
+    {
+        glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &maxAnisotropy);
+        hasAnisotropicFiltering = maxAnisotropy > 1.0f;
+    }
+
+    if (hasGLVersion(4, 4) || hasGLExtension("GL_ARB_buffer_storage"))
+    {
+        BufferStorage = (PFNGLBUFFERSTORAGEEXTPROC)load("glBufferStorage");
+        hasBufferStorage = BufferStorage != nullptr;
+    }
+
+    hasTextureCompressionS3TC = hasGLExtension("GL_EXT_texture_compression_s3tc");
+    hasTextureCompressionBPTC = hasGLVersion(4, 2) || hasGLExtension("GL_ARB_texture_compression_bptc");
+
+    // compute programs are written against #version 430, so the extensions alone are not enough
+    if (hasGLVersion(4, 3))
+    {
+        DispatchCompute = (PFNGLDISPATCHCOMPUTEEXTPROC)load("glDispatchCompute");
+        BindImageTexture = (PFNGLBINDIMAGETEXTUREEXTPROC)load("glBindImageTexture");
+        MemBarrier = (PFNGLMEMORYBARRIEREXTPROC)load("glMemoryBarrier");
+        glGetIntegerv(GL_MAX_COMPUTE_SHARED_MEMORY_SIZE, &maxComputeSharedMemory);
+        hasComputeShader = DispatchCompute && BindImageTexture && MemBarrier;
+    }
+}
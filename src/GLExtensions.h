@@ -0,0 +1,91 @@
+#ifndef GL_EXTENSIONS_H
+#define GL_EXTENSIONS_H
+
+#include <glad/glad.h>
+
+// glad was generated for the GL 3.3 core profile only. Entry points from
+// later versions or extensions are loaded here by hand; each group is only
+// usable when its has* flag is set after loadGLExtensions().
+
+// GL 4.1 / ARB_get_program_binary
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH           0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS      0x87FE
+
+typedef void (APIENTRYP PFNGLGETPROGRAMBINARYEXTPROC)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+typedef void (APIENTRYP PFNGLPROGRAMBINARYEXTPROC)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+typedef void (APIENTRYP PFNGLPROGRAMPARAMETERIEXTPROC)(GLuint program, GLenum pname, GLint value);
+
+// KHR_parallel_shader_compile / ARB_parallel_shader_compile
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR           0x91B1
+
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSEXTPROC)(GLuint count);
+
+// EXT_texture_filter_anisotropic (core in GL 4.6)
+#define GL_TEXTURE_MAX_ANISOTROPY_EXT     0x84FE
+#define GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT 0x84FF
+
+// GL 4.4 / ARB_buffer_storage
+#define GL_MAP_PERSISTENT_BIT  0x0040
+#define GL_MAP_COHERENT_BIT    0x0080
+#define GL_CLIENT_STORAGE_BIT  0x0200
+
+typedef void (APIENTRYP PFNGLBUFFERSTORAGEEXTPROC)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
+// EXT_texture_compression_s3tc (BC1/BC3) and GL 4.2 / ARB_texture_compression_bptc (BC7);
+// RGTC (BC5) is core in 3.0. Upload goes through core glCompressedTexImage2D.
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#define GL_COMPRESSED_RGBA_BPTC_UNORM    0x8E8C
+
+// GL 4.3 compute shaders, with GL 4.2 / ARB_shader_image_load_store for their output
+#define GL_COMPUTE_SHADER                    0x91B9
+#define GL_MAX_COMPUTE_SHARED_MEMORY_SIZE    0x8262
+#define GL_TEXTURE_FETCH_BARRIER_BIT         0x00000008
+#define GL_SHADER_IMAGE_ACCESS_BARRIER_BIT   0x00000020
+#define GL_SHADER_STORAGE_BARRIER_BIT        0x00002000
+#define GL_SHADER_STORAGE_BUFFER             0x90D2
+
+typedef void (APIENTRYP PFNGLDISPATCHCOMPUTEEXTPROC)(GLuint groupsX, GLuint groupsY, GLuint groupsZ);
+typedef void (APIENTRYP PFNGLBINDIMAGETEXTUREEXTPROC)(GLuint unit, GLuint texture, GLint level, GLboolean layered, GLint layer, GLenum access, GLenum format);
+typedef void (APIENTRYP PFNGLMEMORYBARRIEREXTPROC)(GLbitfield barriers);
+
+namespace GLExt {
+    extern bool hasProgramBinary;
+    extern PFNGLGETPROGRAMBINARYEXTPROC GetProgramBinary;
+    extern PFNGLPROGRAMBINARYEXTPROC ProgramBinary;
+    extern PFNGLPROGRAMPARAMETERIEXTPROC ProgramParameteri;
+
+    // GL_COMPLETION_STATUS_KHR can be queried without blocking
+    extern bool hasParallelShaderCompile;
+    extern PFNGLMAXSHADERCOMPILERTHREADSEXTPROC MaxShaderCompilerThreads;
+
+    extern bool hasAnisotropicFiltering;
+    extern float maxAnisotropy;
+
+    // immutable buffers that can stay mapped while the GPU reads them
+    extern bool hasBufferStorage;
+    extern PFNGLBUFFERSTORAGEEXTPROC BufferStorage;
+
+    extern bool hasTextureCompressionS3TC;
+    extern bool hasTextureCompressionBPTC;
+
+    // compute programs (#version 430) that write images
+    extern bool hasComputeShader;
+    extern int maxComputeSharedMemory;
+    extern PFNGLDISPATCHCOMPUTEEXTPROC DispatchCompute;
+    extern PFNGLBINDIMAGETEXTUREEXTPROC BindImageTexture;
+    // glMemoryBarrier; winnt.h defines MemoryBarrier as a macro
+    extern PFNGLMEMORYBARRIEREXTPROC MemBarrier;
+}
+
+// True if the context's version is at least major.minor
+bool hasGLVersion(int major, int minor);
+// True if the context advertises the named extension
+bool hasGLExtension(const char* name);
+
+// Call once after gladLoadGLLoader with the same loader function
+void loadGLExtensions(GLADloadproc load);
+
+#endif // GL_EXTENSIONS_H
@@ -0,0 +1,253 @@
+#include "GLState.h"
+
+namespace {
+    const GLuint UNKNOWN = 0xFFFFFFFFu;
+    // units and targets above these are not tracked and always issued
+    const int TRACKED_UNITS = 16;
+    const GLenum TRACKED_TARGETS[] = {
+        GL_TEXTURE_2D, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_3D, GL_TEXTURE_BUFFER,
+        GL_TEXTURE_2D_MULTISAMPLE, GL_TEXTURE_CUBE_MAP
+    };
+    const int TARGET_COUNT = sizeof(TRACKED_TARGETS) / sizeof(TRACKED_TARGETS[0]);
+    const GLenum TRACKED_CAPABILITIES[] = { GL_DEPTH_TEST, GL_BLEND, GL_CULL_FACE };
+    const int CAPABILITY_COUNT = sizeof(TRACKED_CAPABILITIES) / sizeof(TRACKED_CAPABILITIES[0]);
+
+    struct State {
+        GLuint program;
+        GLuint vertexArray;
+        GLenum activeUnit;
+        GLuint textures[TRACKED_UNITS][TARGET_COUNT];
+        GLuint drawFramebuffer, readFramebuffer;
+        GLenum polygonMode;
+        GLuint capabilities[CAPABILITY_COUNT]; // 0, 1 or UNKNOWN
+        GLenum blendSource, blendDestination, blendEquation;
+        GLuint depthMask;
+        GLenum depthFunc;
+    };
+
+    State state;
+    GLState::Counters counters, lastFrameCounters;
+
+    // True (and counted as issued) when value differs from the cached one
+    bool change(GLState::Call call, GLuint& cached, GLuint value)
+    {
+        if (cached == value)
+        {
+            counters.skipped[call]++;
+            return false;
+        }
+        cached = value;
+        counters.issued[call]++;
+        return true;
+    }
+
+    int targetIndex(GLenum target)
+    {
+        for (int i = 0; i < TARGET_COUNT; i++)
+            if (TRACKED_TARGETS[i] == target)
+                return i;
+        return -1;
+    }
+
+    int capabilityIndex(GLenum capability)
+    {
+        for (int i = 0; i < CAPABILITY_COUNT; i++)
+            if (TRACKED_CAPABILITIES[i] == capability)
+                return i;
+        return -1;
+    }
+}
+
+namespace GLState {
+    const char* getCallName(Call call)
+    {
+        static const char* names[CALL_KINDS] = {
+            "Program", "Vertex array", "Active texture", "Texture", "Framebuffer",
+            "Polygon mode", "Enable/disable", "Blend", "Depth"
+        };
+        return call < CALL_KINDS ? names[call] : "?";
+    }
+
+    void useProgram(GLuint program)
+    {
+        if (change(CALL_PROGRAM, state.program, program))
+            glUseProgram(program);
+    }
+
+    void bindVertexArray(GLuint vertexArray)
+    {
+        if (change(CALL_VERTEX_ARRAY, state.vertexArray, vertexArray))
+            glBindVertexArray(vertexArray);
+    }
+
+    void activeTexture(GLenum unit)
+    {
+        if (change(CALL_ACTIVE_TEXTURE, state.activeUnit, unit))
+            glActiveTexture(unit);
+    }
+
+    void bindTexture(GLenum target, GLuint texture)
+    {
+        int unit = state.activeUnit == UNKNOWN ? -1 : (int)(state.activeUnit - GL_TEXTURE0);
+        int index = targetIndex(target);
+        if (unit < 0 || unit >= TRACKED_UNITS || index < 0)
+        {
+            counters.issued[CALL_TEXTURE]++;
+            glBindTexture(target, texture);
+            return;
+        }
+        if (change(CALL_TEXTURE, state.textures[unit][index], texture))
+            glBindTexture(target, texture);
+    }
+
+    void bindFramebuffer(GLenum target, GLuint framebuffer)
+    {
+        bool draw = target == GL_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER;
+        bool read = target == GL_FRAMEBUFFER || target == GL_READ_FRAMEBUFFER;
+        if ((!draw || state.drawFramebuffer == framebuffer) && (!read || state.readFramebuffer == framebuffer))
+        {
+            counters.skipped[CALL_FRAMEBUFFER]++;
+            return;
+        }
+        if (draw)
+            state.drawFramebuffer = framebuffer;
+        if (read)
+            state.readFramebuffer = framebuffer;
+        counters.issued[CALL_FRAMEBUFFER]++;
+        glBindFramebuffer(target, framebuffer);
+    }
+
+    void polygonMode(GLenum face, GLenum mode)
+    {
+        // core profile only has GL_FRONT_AND_BACK
+        if (change(CALL_POLYGON_MODE, state.polygonMode, mode))
+            glPolygonMode(face, mode);
+    }
+
+    void enable(GLenum capability)
+    {
+        int index = capabilityIndex(capability);
+        if (index < 0)
+        {
+            counters.issued[CALL_CAPABILITY]++;
+            glEnable(capability);
+        }
+        else if (change(CALL_CAPABILITY, state.capabilities[index], 1))
+        {
+            glEnable(capability);
+        }
+    }
+
+    void disable(GLenum capability)
+    {
+        int index = capabilityIndex(capability);
+        if (index < 0)
+        {
+            counters.issued[CALL_CAPABILITY]++;
+            glDisable(capability);
+        }
+        else if (change(CALL_CAPABILITY, state.capabilities[index], 0))
+        {
+            glDisable(capability);
+        }
+    }
+
+    void blendFunc(GLenum source, GLenum destination)
+    {
+        if (state.blendSource == source && state.blendDestination == destination)
+        {
+            counters.skipped[CALL_BLEND]++;
+            return;
+        }
+        state.blendSource = source;
+        state.blendDestination = destination;
+        counters.issued[CALL_BLEND]++;
+        glBlendFunc(source, destination);
+    }
+
+    void blendEquation(GLenum mode)
+    {
+        if (change(CALL_BLEND, state.blendEquation, mode))
+            glBlendEquation(mode);
+    }
+
+    void depthMask(GLboolean flag)
+    {
+        if (change(CALL_DEPTH, state.depthMask, flag ? 1u : 0u))
+            glDepthMask(flag);
+    }
+
+    void depthFunc(GLenum func)
+    {
+        if (change(CALL_DEPTH, state.depthFunc, func))
+            glDepthFunc(func);
+    }
+
+    void deleteTextures(GLsizei count, const GLuint* textures)
+    {
+        // GL unbinds a deleted texture from every unit it is bound to
+        for (GLsizei i = 0; i < count; i++)
+            for (auto& unit : state.textures)
+                for (GLuint& bound : unit)
+                    if (bound == textures[i])
+                        bound = 0;
+        glDeleteTextures(count, textures);
+    }
+
+    void deleteVertexArrays(GLsizei count, const GLuint* vertexArrays)
+    {
+        for (GLsizei i = 0; i < count; i++)
+            if (state.vertexArray == vertexArrays[i])
+                state.vertexArray = 0;
+        glDeleteVertexArrays(count, vertexArrays);
+    }
+
+    void deleteFramebuffers(GLsizei count, const GLuint* framebuffers)
+    {
+        for (GLsizei i = 0; i < count; i++)
+        {
+            if (state.drawFramebuffer == framebuffers[i])
+                state.drawFramebuffer = 0;
+            if (state.readFramebuffer == framebuffers[i])
+                state.readFramebuffer = 0;
+        }
+        glDeleteFramebuffers(count, framebuffers);
+    }
+
+    void deleteProgram(GLuint program)
+    {
+        // a program in use lives on until replaced, so only forget it
+        if (state.program == program)
+            state.program = UNKNOWN;
+        glDeleteProgram(program);
+    }
+
+    void invalidate()
+    {
+        state.program = UNKNOWN;
+        state.vertexArray = UNKNOWN;
+        state.activeUnit = UNKNOWN;
+        for (auto& unit : state.textures)
+            for (GLuint& bound : unit)
+                bound = UNKNOWN;
+        state.drawFramebuffer = state.readFramebuffer = UNKNOWN;
+        state.polygonMode = UNKNOWN;
+        for (GLuint& enabled : state.capabilities)
+            enabled = UNKNOWN;
+        state.blendSource = state.blendDestination = state.blendEquation = UNKNOWN;
+        state.depthMask = UNKNOWN;
+        state.depthFunc = UNKNOWN;
+    }
+
+    void beginFrame()
+    {
+        lastFrameCounters = counters;
+        counters = Counters();
+        invalidate();
+    }
+
+    const Counters& getLastFrameCounters()
+    {
+        return lastFrameCounters;
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef GL_STATE_H
+#define GL_STATE_H
+
+#include <glad/glad.h>
+
+// Shadow copy of the GL state the renderer changes most: the program,
+// vertex array, texture bindings per unit, framebuffers, polygon mode,
+// depth and blend state. Each function mirrors the GL call of the same
+// name and only issues it when the value actually changes, counting issued
+// and skipped calls per frame. All code changing this state must go
+// through here (or call invalidate()) so the copy stays true; deleting
+// objects goes through here too so a recycled name is not mistaken for
+// one still bound.
+namespace GLState {
+    enum Call {
+        CALL_PROGRAM,
+        CALL_VERTEX_ARRAY,
+        CALL_ACTIVE_TEXTURE,
+        CALL_TEXTURE,
+        CALL_FRAMEBUFFER,
+        CALL_POLYGON_MODE,
+        CALL_CAPABILITY,
+        CALL_BLEND,
+        CALL_DEPTH,
+        CALL_KINDS
+    };
+
+    struct Counters {
+        unsigned int issued[CALL_KINDS] = {};
+        unsigned int skipped[CALL_KINDS] = {};
+    };
+
+    const char* getCallName(Call call);
+
+    void useProgram(GLuint program);
+    void bindVertexArray(GLuint vertexArray);
+    void activeTexture(GLenum unit);
+    // Binds to the active unit, like glBindTexture
+    void bindTexture(GLenum target, GLuint texture);
+    void bindFramebuffer(GLenum target, GLuint framebuffer);
+    void polygonMode(GLenum face, GLenum mode);
+    // GL_DEPTH_TEST, GL_BLEND and GL_CULL_FACE are tracked; others pass through
+    void enable(GLenum capability);
+    void disable(GLenum capability);
+    void blendFunc(GLenum source, GLenum destination);
+    void blendEquation(GLenum mode);
+    void depthMask(GLboolean flag);
+    void depthFunc(GLenum func);
+
+    void deleteTextures(GLsizei count, const GLuint* textures);
+    void deleteVertexArrays(GLsizei count, const GLuint* vertexArrays);
+    void deleteFramebuffers(GLsizei count, const GLuint* framebuffers);
+    void deleteProgram(GLuint program);
+
+    // Forgets everything, so the next call of each kind reaches GL; also
+    // call once after the context is created
+    void invalidate();
+    // Once per frame: keeps the finished frame's counters and starts over
+    void beginFrame();
+    const Counters& getLastFrameCounters();
+}
+
+#endif // GL_STATE_H
@@ -0,0 +1,55 @@
+#include "GpuTimer.h"
+
+GpuTimer::GpuTimer()
+    : m_Next(0), m_Active(-1), m_Milliseconds(0.0), m_Samples(0)
+{
+    glGenQueries(QUERY_COUNT, m_Queries);
+    for (bool& pending : m_Pending)
+        pending = false;
+}
+
+GpuTimer::~GpuTimer()
+{
+    glDeleteQueries(QUERY_COUNT, m_Queries);
+}
+
+void GpuTimer::begin()
+{
+    collect();
+    m_Active = -1;
+    if (m_Pending[m_Next])
+        return;
+    m_Active = m_Next;
+    m_Next = (m_Next + 1) % QUERY_COUNT;
+    glBeginQuery(GL_TIME_ELAPSED, m_Queries[m_Active]);
+}
+
+void GpuTimer::end()
+{
+    if (m_Active < 0)
+        return;
+    glEndQuery(GL_TIME_ELAPSED);
+    m_Pending[m_Active] = true;
+    m_Active = -1;
+}
+
+void GpuTimer::collect()
+{
+    for (int i = 0; i < QUERY_COUNT; i++)
+    {
+        if (!m_Pending[i])
+            continue;
+        int available = 0;
+        glGetQueryObjectiv(m_Queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            continue;
+
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(m_Queries[i], GL_QUERY_RESULT, &nanoseconds);
+        m_Pending[i] = false;
+        double milliseconds = nanoseconds / 1000000.0;
+        // a short running average keeps the readout steady
+        m_Milliseconds = m_Samples == 0 ? milliseconds : m_Milliseconds * 0.9 + milliseconds * 0.1;
+        m_Samples++;
+    }
+}
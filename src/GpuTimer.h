@@ -0,0 +1,39 @@
+#ifndef GPU_TIMER_H
+#define GPU_TIMER_H
+
+#include <glad/glad.h>
+
+// Measures the GPU time of the commands between begin() and end() with
+// GL_TIME_ELAPSED queries. Results arrive a few frames late; a small ring of
+// queries means reading them never stalls, and a frame whose query slot is
+// still in flight is simply not measured. Only one timer may be running at a
+// time (GL does not nest elapsed-time queries).
+class GpuTimer {
+public:
+    GpuTimer();
+    ~GpuTimer();
+
+    GpuTimer(const GpuTimer&) = delete;
+    GpuTimer& operator=(const GpuTimer&) = delete;
+
+    void begin();
+    void end();
+
+    // Smoothed over recent measurements; 0 until the first one is available
+    double getMilliseconds() const { return m_Milliseconds; }
+    bool hasResult() const { return m_Samples > 0; }
+
+private:
+    static const int QUERY_COUNT = 4;
+
+    unsigned int m_Queries[QUERY_COUNT];
+    bool m_Pending[QUERY_COUNT];
+    int m_Next;
+    int m_Active;
+    double m_Milliseconds;
+    int m_Samples;
+
+    void collect();
+};
+
+#endif // GPU_TIMER_H
@@ -0,0 +1,39 @@
+#include "InstanceBuffer.h"
+
+InstanceBuffer::InstanceBuffer()
+    : m_Buffer(0), m_BufferSize(0), m_Count(0)
+{
+    glGenBuffers(1, &m_Buffer);
+    // the current value vertex arrays without the attribute read
+    glVertexAttribI4i(INSTANCE_ATTRIBUTE, 0, 0, 0, 0);
+}
+
+InstanceBuffer::~InstanceBuffer()
+{
+    glDeleteBuffers(1, &m_Buffer);
+}
+
+void InstanceBuffer::upload(const std::vector<int>& drawIndices)
+{
+    m_Count = drawIndices.size();
+    if (m_Count == 0)
+        return;
+
+    // orphan the previous contents instead of waiting for the GPU to finish with them
+    size_t bytes = m_Count * sizeof(int);
+    glBindBuffer(GL_ARRAY_BUFFER, m_Buffer);
+    if (bytes > m_BufferSize)
+        m_BufferSize = bytes * 2;
+    glBufferData(GL_ARRAY_BUFFER, m_BufferSize, NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, drawIndices.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void InstanceBuffer::attach(int first) const
+{
+    glBindBuffer(GL_ARRAY_BUFFER, m_Buffer);
+    glEnableVertexAttribArray(INSTANCE_ATTRIBUTE);
+    glVertexAttribIPointer(INSTANCE_ATTRIBUTE, 1, GL_INT, sizeof(int), (void*)(first * sizeof(int)));
+    glVertexAttribDivisor(INSTANCE_ATTRIBUTE, 1);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
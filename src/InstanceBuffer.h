@@ -0,0 +1,41 @@
+#ifndef INSTANCE_BUFFER_H
+#define INSTANCE_BUFFER_H
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <vector>
+
+// Vertex attribute shader.vert reads the instance's draw index from
+const unsigned int INSTANCE_ATTRIBUTE = 3;
+
+// Per-instance draw indices streamed to shader.vert through a vertex
+// attribute with a divisor of 1, so one glDrawElementsInstanced draws many
+// copies of a mesh, each reading its own matrices and texture rectangle from
+// the TransformBatch. The buffer is refilled every frame; instances of one
+// draw are a contiguous range of it. Where the attribute is not enabled it
+// reads 0, so single draws keep selecting themselves with the drawIndex
+// uniform.
+class InstanceBuffer {
+public:
+    InstanceBuffer();
+    ~InstanceBuffer();
+
+    InstanceBuffer(const InstanceBuffer&) = delete;
+    InstanceBuffer& operator=(const InstanceBuffer&) = delete;
+
+    void upload(const std::vector<int>& drawIndices);
+
+    // Points the bound vertex array's instance attribute at the range
+    // starting at first. GL 3.3 has no base instance, so the attribute
+    // offset moves instead.
+    void attach(int first) const;
+
+    size_t size() const { return m_Count; }
+
+private:
+    unsigned int m_Buffer;
+    size_t m_BufferSize;
+    size_t m_Count;
+};
+
+#endif // INSTANCE_BUFFER_H
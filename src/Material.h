@@ -0,0 +1,24 @@
+#ifndef MATERIAL_H
+#define MATERIAL_H
+
+#include <string>
+#include <vector>
+
+// Feature bits of the lit shader (shader.vert/shader.frag). Bit i enables
+// litShaderKeys()[i], so the two lists must stay in the same order.
+enum MaterialFeature : unsigned int {
+    MATERIAL_USE_TEXTURE = 1u << 0,
+    // sampled from a TexturePack array layer instead of its own texture;
+    // takes precedence over MATERIAL_USE_TEXTURE
+    MATERIAL_TEXTURE_ARRAY = 1u << 1,
+    // streamed from a VirtualTexture; takes precedence over both of the above
+    MATERIAL_VIRTUAL_TEXTURE = 1u << 2,
+};
+
+inline const std::vector<std::string>& litShaderKeys()
+{
+    static const std::vector<std::string> keys = { "USE_TEXTURE", "USE_TEXTURE_ARRAY", "USE_VIRTUAL_TEXTURE" };
+    return keys;
+}
+
+#endif // MATERIAL_H
@@ -0,0 +1,206 @@
+#include "MipGenerator.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define MIP_GENERATOR_SSE 1
+#include <xmmintrin.h>
+#endif
+
+namespace {
+    const int LINEAR_TO_SRGB_SIZE = 4096;
+
+    struct ColorTables {
+        float srgbToLinear[256];
+        unsigned char linearToSrgb[LINEAR_TO_SRGB_SIZE];
+
+        ColorTables()
+        {
+            for (int i = 0; i < 256; i++)
+            {
+                float c = i / 255.0f;
+                srgbToLinear[i] = c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+            }
+            for (int i = 0; i < LINEAR_TO_SRGB_SIZE; i++)
+            {
+                float l = i / float(LINEAR_TO_SRGB_SIZE - 1);
+                float c = l <= 0.0031308f ? l * 12.92f : 1.055f * powf(l, 1.0f / 2.4f) - 0.055f;
+                linearToSrgb[i] = (unsigned char)std::min(255.0f, c * 255.0f + 0.5f);
+            }
+        }
+    };
+
+    const ColorTables& colorTables()
+    {
+        static ColorTables tables;
+        return tables;
+    }
+
+    struct Tap {
+        int index;
+        float weight;
+    };
+
+    float besselI0(float x)
+    {
+        float sum = 1.0f, term = 1.0f;
+        for (int k = 1; k < 16; k++)
+        {
+            term *= (x / (2.0f * k)) * (x / (2.0f * k));
+            sum += term;
+        }
+        return sum;
+    }
+
+    float kaiserSinc(float t, float radius)
+    {
+        const float alpha = 4.0f;
+        const float pi = 3.14159265358979f;
+        if (fabsf(t) >= radius)
+            return 0.0f;
+        float sinc = t == 0.0f ? 1.0f : sinf(pi * t) / (pi * t);
+        float r = t / radius;
+        return sinc * besselI0(alpha * sqrtf(1.0f - r * r)) / besselI0(alpha);
+    }
+
+    // For each destination texel along one axis, the source texels it reads and their weights
+    std::vector<std::vector<Tap>> buildTaps(int srcSize, int dstSize, MipFilter filter)
+    {
+        std::vector<std::vector<Tap>> taps(dstSize);
+        float scale = float(srcSize) / float(dstSize);
+
+        for (int x = 0; x < dstSize; x++)
+        {
+            std::vector<Tap>& list = taps[x];
+            if (filter == MipFilter::Box)
+            {
+                // every source texel weighted by how much of it the destination footprint covers
+                float begin = x * scale, end = (x + 1) * scale;
+                for (int s = (int)floorf(begin); s < (int)ceilf(end); s++)
+                {
+                    float coverage = std::min(end, s + 1.0f) - std::max(begin, (float)s);
+                    if (coverage > 0.0f)
+                        list.push_back({ s, coverage });
+                }
+            }
+            else
+            {
+                const float radius = 2.0f; // lobes, in destination texels
+                float center = (x + 0.5f) * scale - 0.5f;
+                float support = radius * scale;
+                for (int s = (int)ceilf(center - support); s <= (int)floorf(center + support); s++)
+                {
+                    float weight = kaiserSinc((s - center) / scale, radius);
+                    if (weight != 0.0f)
+                        list.push_back({ s, weight });
+                }
+            }
+
+            float total = 0.0f;
+            for (Tap& tap : list)
+            {
+                tap.index = ((tap.index % srcSize) + srcSize) % srcSize;
+                total += tap.weight;
+            }
+            for (Tap& tap : list)
+                tap.weight /= total;
+        }
+        return taps;
+    }
+
+    // Weighted sum of RGBA texels; one SSE register per texel
+    inline void accumulate(float* out, const float* src, const std::vector<Tap>& taps, int stride)
+    {
+#ifdef MIP_GENERATOR_SSE
+        __m128 sum = _mm_setzero_ps();
+        for (const Tap& tap : taps)
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(src + (size_t)tap.index * stride), _mm_set1_ps(tap.weight)));
+        _mm_storeu_ps(out, sum);
+#else
+        float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        for (const Tap& tap : taps)
+        {
+            const float* texel = src + (size_t)tap.index * stride;
+            for (int c = 0; c < 4; c++)
+                sum[c] += texel[c] * tap.weight;
+        }
+        memcpy(out, sum, sizeof(sum));
+#endif
+    }
+
+    // Separable resample of a linear RGBA float image
+    std::vector<float> resample(const std::vector<float>& src, int srcW, int srcH, int dstW, int dstH, MipFilter filter)
+    {
+        std::vector<std::vector<Tap>> tapsX = buildTaps(srcW, dstW, filter);
+        std::vector<std::vector<Tap>> tapsY = buildTaps(srcH, dstH, filter);
+
+        std::vector<float> rows((size_t)dstW * srcH * 4);
+        for (int y = 0; y < srcH; y++)
+        {
+            const float* srcRow = &src[(size_t)y * srcW * 4];
+            for (int x = 0; x < dstW; x++)
+                accumulate(&rows[((size_t)y * dstW + x) * 4], srcRow, tapsX[x], 4);
+        }
+
+        std::vector<float> dst((size_t)dstW * dstH * 4);
+        for (int y = 0; y < dstH; y++)
+        {
+            for (int x = 0; x < dstW; x++)
+                accumulate(&dst[((size_t)y * dstW + x) * 4], &rows[(size_t)x * 4], tapsY[y], dstW * 4);
+        }
+        // the sinc's negative lobes can ring below zero next to hard edges
+        for (float& value : dst)
+            value = std::max(value, 0.0f);
+        return dst;
+    }
+
+    void encode(const std::vector<float>& linear, MipLevel& level)
+    {
+        const ColorTables& tables = colorTables();
+        level.pixels.resize(linear.size());
+        for (size_t i = 0; i < linear.size(); i += 4)
+        {
+            for (int c = 0; c < 3; c++)
+            {
+                float l = std::min(std::max(linear[i + c], 0.0f), 1.0f);
+                level.pixels[i + c] = tables.linearToSrgb[(int)(l * (LINEAR_TO_SRGB_SIZE - 1) + 0.5f)];
+            }
+            float a = std::min(std::max(linear[i + 3], 0.0f), 1.0f);
+            level.pixels[i + 3] = (unsigned char)(a * 255.0f + 0.5f);
+        }
+    }
+}
+
+std::vector<MipLevel> generateMipChain(const unsigned char* pixels, int width, int height, MipFilter filter)
+{
+    std::vector<MipLevel> chain;
+    chain.push_back({ width, height, std::vector<unsigned char>(pixels, pixels + (size_t)width * height * 4) });
+
+    // decode once; every level is filtered from the previous float level so
+    // quantisation does not accumulate down the chain
+    const ColorTables& tables = colorTables();
+    std::vector<float> linear((size_t)width * height * 4);
+    for (size_t i = 0; i < linear.size(); i += 4)
+    {
+        linear[i + 0] = tables.srgbToLinear[pixels[i + 0]];
+        linear[i + 1] = tables.srgbToLinear[pixels[i + 1]];
+        linear[i + 2] = tables.srgbToLinear[pixels[i + 2]];
+        linear[i + 3] = pixels[i + 3] / 255.0f;
+    }
+
+    int w = width, h = height;
+    while (w > 1 || h > 1)
+    {
+        int nextW = std::max(1, w / 2);
+        int nextH = std::max(1, h / 2);
+        linear = resample(linear, w, h, nextW, nextH, filter);
+        w = nextW;
+        h = nextH;
+
+        MipLevel level = { w, h, {} };
+        encode(linear, level);
+        chain.push_back(std::move(level));
+    }
+    return chain;
+}
@@ -0,0 +1,22 @@
+#ifndef MIP_GENERATOR_H
+#define MIP_GENERATOR_H
+
+#include <vector>
+
+enum class MipFilter {
+    Box,     // cheap, slightly blurry
+    Kaiser   // Kaiser-windowed sinc, keeps distant detail sharper
+};
+
+struct MipLevel {
+    int width;
+    int height;
+    std::vector<unsigned char> pixels; // RGBA8, sRGB-encoded like level 0
+};
+
+// Builds the full mip chain (level 0 included) for an RGBA8 image. RGB is
+// treated as sRGB and filtered in linear space, alpha is filtered linearly.
+// Addressing wraps, matching the GL_REPEAT textures this is used for.
+std::vector<MipLevel> generateMipChain(const unsigned char* pixels, int width, int height, MipFilter filter);
+
+#endif // MIP_GENERATOR_H
@@ -1,27 +1,40 @@
 #include "Model.h"
+#include "GLState.h"
 #include "tiny_obj_loader.h"
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
-Model::Model(const std::string& objPath, const std::string& texturePath)
-    : texture(texturePath)
+Model::Model(const std::string& objPath, std::shared_ptr<Texture> texture)
+    : texture(std::move(texture)), boundsCenter(0.0f), boundsRadius(0.0f), uvDensity(0.0f)
 {
     loadModel(objPath);
     setupMesh();
+    computeBounds();
+}
+
+Model::Model(const std::string& objPath, const TextureSlot& textureSlot)
+    : textureSlot(textureSlot), boundsCenter(0.0f), boundsRadius(0.0f), uvDensity(0.0f)
+{
+    loadModel(objPath);
+    setupMesh();
+    computeBounds();
 }
 
 Model::~Model()
 {
-    glDeleteVertexArrays(1, &VAO);
+    GLState::deleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
     glDeleteBuffers(1, &EBO);
 }
 
-void Model::Draw() const
+void Model::Draw(const InstanceBuffer& instances, int first, int count) const
 {
-    texture.bind();
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
+    if (texture)
+        texture->bind();
+    GLState::bindVertexArray(VAO);
+    instances.attach(first);
+    glDrawElementsInstanced(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0, count);
 }
 
 void Model::loadModel(const std::string& objPath)
@@ -72,7 +85,7 @@ void Model::setupMesh()
     glGenBuffers(1, &VBO);
     glGenBuffers(1, &EBO);
 
-    glBindVertexArray(VAO);
+    GLState::bindVertexArray(VAO);
 
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
     glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
@@ -90,5 +103,49 @@ void Model::setupMesh()
     glEnableVertexAttribArray(2);
     glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
 
-    glBindVertexArray(0);
-}
\ No newline at end of file
+    GLState::bindVertexArray(0);
+}
+
+void Model::computeBounds()
+{
+    if (vertices.empty())
+        return;
+
+    glm::vec3 minimum = vertices[0].Position, maximum = vertices[0].Position;
+    for (const Vertex& vertex : vertices)
+    {
+        minimum = glm::min(minimum, vertex.Position);
+        maximum = glm::max(maximum, vertex.Position);
+    }
+    boundsCenter = (minimum + maximum) * 0.5f;
+    for (const Vertex& vertex : vertices)
+        boundsRadius = std::max(boundsRadius, glm::length(vertex.Position - boundsCenter));
+
+    // ratio of total UV area to total surface area
+    double uvArea = 0.0, surfaceArea = 0.0;
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        const Vertex& a = vertices[indices[i]];
+        const Vertex& b = vertices[indices[i + 1]];
+        const Vertex& c = vertices[indices[i + 2]];
+        surfaceArea += 0.5 * glm::length(glm::cross(b.Position - a.Position, c.Position - a.Position));
+        glm::vec2 u = b.TexCoords - a.TexCoords, v = c.TexCoords - a.TexCoords;
+        uvArea += 0.5 * std::abs(u.x * v.y - u.y * v.x);
+    }
+    if (surfaceArea > 0.0)
+        uvDensity = (float)std::sqrt(uvArea / surfaceArea);
+}
+
+void Model::requestTextureLevel(const glm::mat4& world, const glm::vec3& cameraPosition, float projectionScale) const
+{
+    if (!texture || uvDensity <= 0.0f)
+        return;
+
+    float scale = std::max(glm::length(glm::vec3(world[0])), std::max(glm::length(glm::vec3(world[1])), glm::length(glm::vec3(world[2]))));
+    glm::vec3 center = glm::vec3(world * glm::vec4(boundsCenter, 1.0f));
+    float distance = std::max(glm::length(center - cameraPosition) - boundsRadius * scale, 0.1f);
+
+    float texelsPerUnit = std::max(texture->getWidth(), texture->getHeight()) * uvDensity / scale;
+    float pixelsPerUnit = projectionScale / distance;
+    texture->requestLevel((int)std::floor(std::log2(std::max(texelsPerUnit / pixelsPerUnit, 1.0f))));
+}
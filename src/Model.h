@@ -5,7 +5,11 @@
 #include <glm/glm.hpp>
 #include <vector>
 #include <string>
+#include <memory>
+#include "InstanceBuffer.h"
 #include "Texture.h"
+#include "Material.h"
+#include "TexturePack.h"
 
 struct Vertex {
     glm::vec3 Position;
@@ -15,19 +19,53 @@ struct Vertex {
 
 class Model {
 public:
-    Model(const std::string& objPath, const std::string& texturePath);
+    // texture is usually shared with other models through TextureManager
+    Model(const std::string& objPath, std::shared_ptr<Texture> texture);
+    // textured from a layer of a TexturePack array; the caller binds the array
+    Model(const std::string& objPath, const TextureSlot& textureSlot);
     ~Model();
 
-    void Draw() const;
+    // Draws count instances, their draw indices taken from instances
+    // starting at first
+    void Draw(const InstanceBuffer& instances, int first, int count) const;
+
+    // MaterialFeature bits selecting this model's lit shader variant
+    unsigned int getMaterialFeatures() const
+    {
+        if (textureSlot.array)
+            return MATERIAL_TEXTURE_ARRAY;
+        return texture && texture->getID() ? (unsigned int)MATERIAL_USE_TEXTURE : 0u;
+    }
+    const TextureSlot& getTextureSlot() const { return textureSlot; }
+    // GL names of the vertex array and of the texture or texture array drawn
+    // with, to group draws by
+    unsigned int getMeshID() const { return VAO; }
+    unsigned int getTextureID() const
+    {
+        if (textureSlot.array)
+            return textureSlot.array->getID();
+        return texture ? texture->getID() : 0;
+    }
+
+    // Asks the texture for the mip level its screen-space footprint needs:
+    // texels per world unit (from the mesh's UV density) against pixels per
+    // world unit at the bounding sphere's nearest point. projectionScale is
+    // the viewport height / (2 tan(fovY / 2)).
+    void requestTextureLevel(const glm::mat4& world, const glm::vec3& cameraPosition, float projectionScale) const;
 
 private:
     std::vector<Vertex> vertices;
     std::vector<unsigned int> indices;
     unsigned int VAO, VBO, EBO;
-    Texture texture;
+    std::shared_ptr<Texture> texture;
+    TextureSlot textureSlot;
+    glm::vec3 boundsCenter;
+    float boundsRadius;
+    float uvDensity; // UV units per object space unit, 0 without texture coordinates
 
     void loadModel(const std::string& objPath);
     void setupMesh();
+    void computeBounds();
 };
 
 #endif // MODEL_H
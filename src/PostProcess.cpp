@@ -0,0 +1,186 @@
+#include "PostProcess.h"
+#include "FullscreenQuad.h"
+#include "GLState.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+PostProcess::PostProcess(const std::string& lutPath)
+    : m_shaders("Shaders/fullscreen.vert", "Shaders/post.frag", postShaderKeys()),
+    m_features(0), m_lut(0), m_lutSize(0),
+    m_bakedSaturation(-1.0f), m_bakedContrast(-1.0f), m_bakedTemperature(-1.0f) {
+    if (!lutPath.empty() && loadCube(lutPath))
+        m_lutPath = lutPath;
+}
+
+PostProcess::~PostProcess() {
+    GLState::deleteTextures(1, &m_lut);
+}
+
+void PostProcess::addPass(FrameGraph& graph, const PostInputs& inputs, FrameResource output, const PostSettings& settings) {
+    FrameResource scene = inputs.scene, bloom = inputs.bloom, exposure = inputs.exposure;
+    float bloomScale = inputs.bloomScale;
+    unsigned int features = 0;
+    if (bloom != NO_FRAME_RESOURCE && settings.bloomStrength > 0.0f)
+        features |= POST_BLOOM;
+    if (settings.tonemap) {
+        features |= POST_TONEMAP;
+        if (exposure != NO_FRAME_RESOURCE)
+            features |= POST_AUTO_EXPOSURE;
+    }
+    if (settings.gammaCorrect)
+        features |= POST_GAMMA;
+    const RenderTargetDesc& sceneDesc = graph.getDesc(scene);
+    const RenderTargetDesc& outputDesc = graph.getDesc(output);
+    bool upscaled = sceneDesc.width < outputDesc.width || sceneDesc.height < outputDesc.height;
+    if ((upscaled || inputs.temporal) && settings.sharpness > 0.0f)
+        features |= POST_SHARPEN;
+    if (settings.colorGrading && settings.gradingAmount > 0.0f) {
+        features |= POST_COLOR_GRADING;
+        if (m_lutPath.empty())
+            bakeLut(settings);
+    }
+    m_features = features;
+
+    graph.addPass("Post",
+        [&](FrameGraph::Builder& pass) {
+            pass.read(scene);
+            if (features & POST_BLOOM)
+                pass.read(bloom);
+            if (features & POST_AUTO_EXPOSURE)
+                pass.read(exposure);
+            pass.writeColor(output);
+        },
+        [this, &graph, scene, bloom, bloomScale, exposure, features, settings, sceneDesc]() {
+            GLState::disable(GL_DEPTH_TEST);
+            GLState::disable(GL_BLEND);
+            GLState::polygonMode(GL_FRONT_AND_BACK, GL_FILL);
+            Shader& shader = m_shaders.get(features);
+            shader.use();
+            shader.setInt("scene"_u, 0);
+            GLState::activeTexture(GL_TEXTURE0);
+            GLState::bindTexture(GL_TEXTURE_2D, graph.getTexture(scene));
+            if (features & POST_BLOOM) {
+                shader.setInt("bloomBlur"_u, 1);
+                shader.setFloat("bloomStrength"_u, settings.bloomStrength * bloomScale);
+                GLState::activeTexture(GL_TEXTURE1);
+                GLState::bindTexture(GL_TEXTURE_2D, graph.getTexture(bloom));
+            }
+            if (features & POST_TONEMAP)
+                shader.setFloat("exposure"_u, settings.exposure);
+            if (features & POST_AUTO_EXPOSURE) {
+                shader.setInt("autoExposure"_u, 3);
+                GLState::activeTexture(GL_TEXTURE3);
+                GLState::bindTexture(GL_TEXTURE_2D, graph.getTexture(exposure));
+            }
+            if (features & POST_SHARPEN) {
+                shader.setFloat("sharpness"_u, std::min(settings.sharpness, 1.0f));
+                shader.setVec2("sourceTexel"_u, glm::vec2(1.0f / sceneDesc.width, 1.0f / sceneDesc.height));
+            }
+            if (features & POST_GAMMA)
+                shader.setFloat("gamma"_u, settings.gamma);
+            if (features & POST_COLOR_GRADING) {
+                shader.setInt("gradingLut"_u, 2);
+                shader.setFloat("lutSize"_u, (float)m_lutSize);
+                shader.setFloat("gradingAmount"_u, settings.gradingAmount);
+                GLState::activeTexture(GL_TEXTURE2);
+                GLState::bindTexture(GL_TEXTURE_3D, m_lut);
+            }
+            GLState::activeTexture(GL_TEXTURE0);
+            drawFullscreenQuad();
+            GLState::enable(GL_DEPTH_TEST);
+        });
+}
+
+bool PostProcess::loadCube(const std::string& path) {
+    std::ifstream file(path);
+    if (!file)
+        return false;
+
+    // Adobe .cube: LUT_3D_SIZE then size^3 "r g b" rows, red varying fastest,
+    // which is the texel order of a 3D texture
+    int size = 0;
+    std::vector<float> rgb;
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream record(line);
+        std::string first;
+        if (!(record >> first) || first[0] == '#')
+            continue;
+        if (first == "LUT_3D_SIZE") {
+            record >> size;
+        } else if (first == "TITLE" || first == "DOMAIN_MIN" || first == "DOMAIN_MAX") {
+            continue;
+        } else if (first == "LUT_1D_SIZE") {
+            std::cout << path << ": 1D LUTs are not supported" << std::endl;
+            return false;
+        } else {
+            char* end = nullptr;
+            float r = std::strtof(first.c_str(), &end);
+            float g = 0.0f, b = 0.0f;
+            if (*end != '\0' || !(record >> g >> b)) {
+                std::cout << path << ": invalid entry \"" << line << "\"" << std::endl;
+                return false;
+            }
+            rgb.push_back(r);
+            rgb.push_back(g);
+            rgb.push_back(b);
+        }
+    }
+    if (size < 2 || size > 256 || rgb.size() != (size_t)size * size * size * 3) {
+        std::cout << path << ": expected " << size << "^3 entries, found " << rgb.size() / 3 << std::endl;
+        return false;
+    }
+    uploadLut(size, rgb);
+    return true;
+}
+
+void PostProcess::bakeLut(const PostSettings& settings) {
+    if (m_lut != 0 && settings.saturation == m_bakedSaturation && settings.contrast == m_bakedContrast &&
+        settings.temperature == m_bakedTemperature)
+        return;
+
+    const int size = BAKED_LUT_SIZE;
+    std::vector<float> rgb;
+    rgb.reserve((size_t)size * size * size * 3);
+    for (int b = 0; b < size; b++) {
+        for (int g = 0; g < size; g++) {
+            for (int r = 0; r < size; r++) {
+                float color[3] = { r / (size - 1.0f), g / (size - 1.0f), b / (size - 1.0f) };
+                // white balance: shift along the blue-orange axis
+                color[0] += settings.temperature * 0.1f;
+                color[2] -= settings.temperature * 0.1f;
+                for (float& channel : color)
+                    channel = (channel - 0.5f) * settings.contrast + 0.5f;
+                float luma = 0.2126f * color[0] + 0.7152f * color[1] + 0.0722f * color[2];
+                for (float& channel : color)
+                    rgb.push_back(std::min(std::max(luma + (channel - luma) * settings.saturation, 0.0f), 1.0f));
+            }
+        }
+    }
+    uploadLut(size, rgb);
+    m_bakedSaturation = settings.saturation;
+    m_bakedContrast = settings.contrast;
+    m_bakedTemperature = settings.temperature;
+}
+
+void PostProcess::uploadLut(int size, const std::vector<float>& rgb) {
+    if (m_lut == 0 || size != m_lutSize) {
+        GLState::deleteTextures(1, &m_lut);
+        glGenTextures(1, &m_lut);
+        GLState::bindTexture(GL_TEXTURE_3D, m_lut);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        glTexImage3D(GL_TEXTURE_3D, 0, GL_RGB16F, size, size, size, 0, GL_RGB, GL_FLOAT, rgb.data());
+        m_lutSize = size;
+    } else {
+        GLState::bindTexture(GL_TEXTURE_3D, m_lut);
+        glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0, size, size, size, GL_RGB, GL_FLOAT, rgb.data());
+    }
+    GLState::bindTexture(GL_TEXTURE_3D, 0);
+}
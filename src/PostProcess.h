@@ -0,0 +1,98 @@
+#ifndef POST_PROCESS_H
+#define POST_PROCESS_H
+
+#include <glad/glad.h>
+#include <string>
+#include <vector>
+#include "FrameGraph.h"
+#include "ShaderVariants.h"
+
+struct PostSettings {
+    float exposure = 1.0f; // a multiplier on top of auto exposure when that is used
+    float bloomStrength = 1.0f;
+    bool tonemap = true;
+    bool gammaCorrect = true;
+    float gamma = 2.2f;
+    bool colorGrading = false;
+    float gradingAmount = 1.0f;
+    // applied while the scene is stretched to a larger output, 0 to 1
+    float sharpness = 0.5f;
+    // bake the grading LUT when no .cube file was loaded
+    float saturation = 1.0f;
+    float contrast = 1.0f;
+    float temperature = 0.0f; // -1 cool to 1 warm
+};
+
+// What the post pass reads; all but scene may be NO_FRAME_RESOURCE
+struct PostInputs {
+    FrameResource scene = NO_FRAME_RESOURCE;
+    FrameResource bloom = NO_FRAME_RESOURCE;
+    float bloomScale = 1.0f;                   // brings bloom back to scene brightness
+    FrameResource exposure = NO_FRAME_RESOURCE; // 1x1 R32F from AutoExposure
+    // scene was accumulated over frames (TemporalAA), which softens it
+    bool temporal = false;
+};
+
+// Stages of post.frag. Bit i enables the define postShaderKeys()[i], so the
+// two lists must stay in the same order.
+enum PostFeature : unsigned int {
+    POST_BLOOM = 1u << 0,
+    POST_TONEMAP = 1u << 1,
+    POST_GAMMA = 1u << 2,
+    POST_COLOR_GRADING = 1u << 3,
+    POST_SHARPEN = 1u << 4,
+    POST_AUTO_EXPOSURE = 1u << 5,
+};
+
+inline const std::vector<std::string>& postShaderKeys()
+{
+    static const std::vector<std::string> keys = { "BLOOM", "TONEMAP", "GAMMA", "COLOR_GRADING", "SHARPEN", "AUTO_EXPOSURE" };
+    return keys;
+}
+
+// The whole post chain as a single full-screen pass: bloom composite,
+// exposure tone mapping, gamma and colour grading through a 3D LUT each
+// compile in only when enabled, so the scene is read once and the window
+// written once whichever stages are on. A scene smaller than the output is
+// upscaled by the same pass, bilinearly and then contrast-adaptively
+// sharpened; a temporally accumulated scene is sharpened as well. The LUT comes from a .cube file when
+// one is given and found, and is otherwise baked from the grading settings.
+class PostProcess {
+public:
+    explicit PostProcess(const std::string& lutPath = "Textures/grading.cube");
+    ~PostProcess();
+
+    PostProcess(const PostProcess&) = delete;
+    PostProcess& operator=(const PostProcess&) = delete;
+
+    // Adds the pass that resolves the inputs into output
+    void addPass(FrameGraph& graph, const PostInputs& inputs, FrameResource output, const PostSettings& settings);
+
+    void onFileChanged(const std::string& path) { m_shaders.onFileChanged(path); }
+    void pollReload() { m_shaders.pollReload(); }
+
+    // Variant mask the last pass was drawn with
+    unsigned int getFeatures() const { return m_features; }
+    size_t getVariantCount() const { return m_shaders.getVariantCount(); }
+    bool isLutLoaded() const { return !m_lutPath.empty(); }
+    const std::string& getLutPath() const { return m_lutPath; }
+    int getLutSize() const { return m_lutSize; }
+
+private:
+    static const int BAKED_LUT_SIZE = 32;
+
+    ShaderVariants m_shaders;
+    unsigned int m_features;
+
+    unsigned int m_lut;
+    int m_lutSize;
+    std::string m_lutPath; // empty while the LUT is baked
+    // grading settings the baked LUT was built from
+    float m_bakedSaturation, m_bakedContrast, m_bakedTemperature;
+
+    bool loadCube(const std::string& path);
+    void bakeLut(const PostSettings& settings);
+    void uploadLut(int size, const std::vector<float>& rgb);
+};
+
+#endif // POST_PROCESS_H
@@ -0,0 +1,112 @@
+#include "ProgramBinaryCache.h"
+#include "GLExtensions.h"
+#include <filesystem>
+#include <fstream>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+
+std::string ProgramBinaryCache::s_Directory = "ShaderCache";
+
+namespace {
+    const uint32_t CACHE_MAGIC = 0x31434250; // "PBC1"
+
+    struct CacheHeader {
+        uint32_t magic;
+        uint32_t format;
+        uint32_t length;
+        uint32_t reserved;
+        uint64_t key;
+    };
+
+    uint64_t hashBytes(uint64_t hash, const char* data, size_t size)
+    {
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= static_cast<uint8_t>(data[i]);
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    uint64_t hashString(uint64_t hash, const char* str)
+    {
+        // include the terminator so "ab"+"c" and "a"+"bc" differ
+        return str ? hashBytes(hash, str, strlen(str) + 1) : hashBytes(hash, "", 1);
+    }
+}
+
+uint64_t ProgramBinaryCache::hash(const std::string& data, uint64_t seed)
+{
+    uint64_t hash = 14695981039346656037ull ^ seed;
+    return hashBytes(hash, data.data(), data.size());
+}
+
+uint64_t ProgramBinaryCache::makeKey(std::initializer_list<const std::string*> sources)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (const std::string* source : sources)
+        hash = hashString(hash, source->c_str());
+    hash = hashString(hash, (const char*)glGetString(GL_VENDOR));
+    hash = hashString(hash, (const char*)glGetString(GL_RENDERER));
+    hash = hashString(hash, (const char*)glGetString(GL_VERSION));
+    return hash;
+}
+
+std::string ProgramBinaryCache::pathFor(uint64_t key)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+    return s_Directory + "/" + name;
+}
+
+bool ProgramBinaryCache::load(unsigned int program, uint64_t key)
+{
+    if (!GLExt::hasProgramBinary)
+        return false;
+
+    std::ifstream file(pathFor(key), std::ios::binary);
+    if (!file)
+        return false;
+
+    CacheHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        header.magic != CACHE_MAGIC || header.key != key)
+        return false;
+
+    std::vector<char> binary(header.length);
+    if (!file.read(binary.data(), binary.size()))
+        return false;
+
+    GLExt::ProgramBinary(program, header.format, binary.data(), (GLsizei)binary.size());
+
+    int success = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    return success != 0;
+}
+
+void ProgramBinaryCache::save(unsigned int program, uint64_t key)
+{
+    if (!GLExt::hasProgramBinary)
+        return;
+
+    int length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    GLExt::GetProgramBinary(program, length, &length, &format, binary.data());
+
+    std::error_code ec;
+    std::filesystem::create_directories(s_Directory, ec);
+
+    std::ofstream file(pathFor(key), std::ios::binary | std::ios::trunc);
+    if (!file)
+        return;
+
+    CacheHeader header = { CACHE_MAGIC, format, (uint32_t)length, 0, key };
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(binary.data(), length);
+}
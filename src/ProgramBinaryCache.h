@@ -0,0 +1,31 @@
+#ifndef PROGRAM_BINARY_CACHE_H
+#define PROGRAM_BINARY_CACHE_H
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <string>
+#include <initializer_list>
+
+// Stores linked programs on disk with glGetProgramBinary so later runs can
+// skip GLSL compilation. Entries are keyed by the stage sources plus the
+// driver's vendor/renderer/version strings, so a driver update misses.
+class ProgramBinaryCache {
+public:
+    static uint64_t makeKey(std::initializer_list<const std::string*> sources);
+    // 64-bit FNV-1a of data, seeded so equal text in different stages differs
+    static uint64_t hash(const std::string& data, uint64_t seed = 0);
+
+    // Restores a cached binary into program; false on a miss or if the driver rejects it
+    static bool load(unsigned int program, uint64_t key);
+    // Writes program's binary; program must be linked with the retrievable hint set
+    static void save(unsigned int program, uint64_t key);
+
+    static void setDirectory(const std::string& directory) { s_Directory = directory; }
+
+private:
+    static std::string s_Directory;
+
+    static std::string pathFor(uint64_t key);
+};
+
+#endif // PROGRAM_BINARY_CACHE_H
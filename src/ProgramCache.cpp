@@ -0,0 +1,204 @@
+#include "ProgramCache.h"
+#include "GLExtensions.h"
+#include "GLState.h"
+#include "ProgramBinaryCache.h"
+#include <iostream>
+
+std::unordered_map<uint64_t, ProgramCache::Stage> ProgramCache::s_Stages;
+std::unordered_map<uint64_t, unsigned int> ProgramCache::s_ProgramsByKey;
+std::unordered_map<unsigned int, ProgramCache::Program> ProgramCache::s_Programs;
+unsigned int ProgramCache::s_SharedCount = 0;
+
+unsigned int ProgramCache::acquire(const std::string& vertexCode, const std::string& fragmentCode)
+{
+    uint64_t vertexKey = ProgramBinaryCache::hash(vertexCode, GL_VERTEX_SHADER);
+    uint64_t fragmentKey = ProgramBinaryCache::hash(fragmentCode, GL_FRAGMENT_SHADER);
+    uint64_t key = vertexKey ^ (fragmentKey * 1099511628211ull);
+
+    auto existing = s_ProgramsByKey.find(key);
+    if (existing != s_ProgramsByKey.end())
+    {
+        s_Programs[existing->second].refs++;
+        s_SharedCount++;
+        return existing->second;
+    }
+
+    Program entry = {};
+    entry.key = key;
+    entry.binaryKey = ProgramBinaryCache::makeKey({ &vertexCode, &fragmentCode });
+    return addProgram(entry, { { GL_VERTEX_SHADER, &vertexCode }, { GL_FRAGMENT_SHADER, &fragmentCode } });
+}
+
+unsigned int ProgramCache::acquireCompute(const std::string& computeCode)
+{
+    uint64_t key = ProgramBinaryCache::hash(computeCode, GL_COMPUTE_SHADER);
+
+    auto existing = s_ProgramsByKey.find(key);
+    if (existing != s_ProgramsByKey.end())
+    {
+        s_Programs[existing->second].refs++;
+        s_SharedCount++;
+        return existing->second;
+    }
+
+    Program entry = {};
+    entry.key = key;
+    entry.binaryKey = ProgramBinaryCache::makeKey({ &computeCode });
+    return addProgram(entry, { { GL_COMPUTE_SHADER, &computeCode } });
+}
+
+unsigned int ProgramCache::addProgram(Program& entry, const std::vector<std::pair<GLenum, const std::string*>>& stages)
+{
+    entry.refs = 1;
+
+    // try the on-disk program binary cache first
+    unsigned int program = glCreateProgram();
+    if (ProgramBinaryCache::load(program, entry.binaryKey))
+    {
+        entry.finished = entry.linked = entry.fromDisk = true;
+    }
+    else
+    {
+        // issue compile and link only; status is not queried until finish()
+        // so the driver can work on several programs at once
+        if (GLExt::hasProgramBinary)
+            GLExt::ProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        for (const auto& stage : stages)
+        {
+            uint64_t& key = stage.first == GL_VERTEX_SHADER ? entry.vertexKey :
+                stage.first == GL_FRAGMENT_SHADER ? entry.fragmentKey : entry.computeKey;
+            glAttachShader(program, acquireStage(stage.first, *stage.second, key));
+        }
+        glLinkProgram(program);
+    }
+
+    s_ProgramsByKey[entry.key] = program;
+    s_Programs[program] = entry;
+    return program;
+}
+
+void ProgramCache::release(unsigned int program)
+{
+    auto it = s_Programs.find(program);
+    if (it == s_Programs.end() || --it->second.refs > 0)
+        return;
+
+    if (!it->second.finished && !it->second.fromDisk)
+    {
+        releaseStage(program, it->second.vertexKey);
+        releaseStage(program, it->second.fragmentKey);
+        releaseStage(program, it->second.computeKey);
+    }
+    s_ProgramsByKey.erase(it->second.key);
+    s_Programs.erase(it);
+    GLState::deleteProgram(program);
+}
+
+bool ProgramCache::isComplete(unsigned int program)
+{
+    auto it = s_Programs.find(program);
+    if (it == s_Programs.end() || it->second.finished || !GLExt::hasParallelShaderCompile)
+        return true;
+
+    int done = 0;
+    glGetProgramiv(program, GL_COMPLETION_STATUS_KHR, &done);
+    return done != 0;
+}
+
+bool ProgramCache::finish(unsigned int program)
+{
+    auto it = s_Programs.find(program);
+    if (it == s_Programs.end())
+        return false;
+    Program& entry = it->second;
+    if (entry.finished)
+        return entry.linked;
+
+    checkStage(entry.vertexKey, "VERTEX");
+    checkStage(entry.fragmentKey, "FRAGMENT");
+    checkStage(entry.computeKey, "COMPUTE");
+
+    entry.linked = checkCompileErrors(program, "PROGRAM");
+    if (entry.linked)
+        ProgramBinaryCache::save(program, entry.binaryKey);
+    entry.finished = true;
+
+    // the stages are linked into our program now and no longer necessary
+    releaseStage(program, entry.vertexKey);
+    releaseStage(program, entry.fragmentKey);
+    releaseStage(program, entry.computeKey);
+    return entry.linked;
+}
+
+bool ProgramCache::wasLoadedFromDisk(unsigned int program)
+{
+    auto it = s_Programs.find(program);
+    return it != s_Programs.end() && it->second.fromDisk;
+}
+
+unsigned int ProgramCache::acquireStage(GLenum type, const std::string& code, uint64_t& key)
+{
+    key = ProgramBinaryCache::hash(code, type);
+    auto it = s_Stages.find(key);
+    if (it != s_Stages.end())
+    {
+        it->second.refs++;
+        return it->second.id;
+    }
+
+    const char* source = code.c_str();
+    unsigned int shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+    s_Stages[key] = { shader, 1, false };
+    return shader;
+}
+
+void ProgramCache::checkStage(uint64_t key, const char* type)
+{
+    // stages shared between programs only report their errors once
+    auto it = s_Stages.find(key);
+    if (it == s_Stages.end() || it->second.checked)
+        return;
+    checkCompileErrors(it->second.id, type);
+    it->second.checked = true;
+}
+
+void ProgramCache::releaseStage(unsigned int program, uint64_t key)
+{
+    auto it = s_Stages.find(key);
+    if (it == s_Stages.end())
+        return;
+
+    glDetachShader(program, it->second.id);
+    if (--it->second.refs == 0)
+    {
+        glDeleteShader(it->second.id);
+        s_Stages.erase(it);
+    }
+}
+
+bool ProgramCache::checkCompileErrors(unsigned int shader, std::string type)
+{
+    int success;
+    char infoLog[1024];
+    if (type != "PROGRAM")
+    {
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+        if (!success)
+        {
+            glGetShaderInfoLog(shader, 1024, NULL, infoLog);
+            std::cout << "ERROR::SHADER_COMPILATION_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
+        }
+    }
+    else
+    {
+        glGetProgramiv(shader, GL_LINK_STATUS, &success);
+        if (!success)
+        {
+            glGetProgramInfoLog(shader, 1024, NULL, infoLog);
+            std::cout << "ERROR::PROGRAM_LINKING_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
+        }
+    }
+    return success != 0;
+}
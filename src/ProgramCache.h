@@ -0,0 +1,65 @@
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Owns every linked program, keyed by the hashes of its stage sources, so
+// identical programs (and identical stages, e.g. the shared full-screen
+// vertex shader) are only compiled once. acquire() only issues compile and
+// link; the result is checked in finish(), which lets a caller submit many
+// programs before waiting on any of them.
+class ProgramCache {
+public:
+    // Returns a reference to the program built from these sources
+    static unsigned int acquire(const std::string& vertexCode, const std::string& fragmentCode);
+    // Same for a compute program; only valid when GLExt::hasComputeShader
+    static unsigned int acquireCompute(const std::string& computeCode);
+    static void release(unsigned int program);
+
+    // True once the link has finished; never blocks when
+    // KHR_parallel_shader_compile is available, otherwise always true
+    static bool isComplete(unsigned int program);
+    // Waits for the link, logs compile/link errors once and returns success
+    static bool finish(unsigned int program);
+
+    static bool wasLoadedFromDisk(unsigned int program);
+    static size_t getProgramCount() { return s_Programs.size(); }
+    static unsigned int getSharedCount() { return s_SharedCount; }
+
+private:
+    struct Stage {
+        unsigned int id;
+        int refs;
+        bool checked;
+    };
+
+    struct Program {
+        uint64_t key;
+        uint64_t binaryKey;
+        uint64_t vertexKey;
+        uint64_t fragmentKey;
+        uint64_t computeKey;
+        int refs;
+        bool finished;
+        bool linked;
+        bool fromDisk;
+    };
+
+    static std::unordered_map<uint64_t, Stage> s_Stages;
+    static std::unordered_map<uint64_t, unsigned int> s_ProgramsByKey;
+    static std::unordered_map<unsigned int, Program> s_Programs;
+    static unsigned int s_SharedCount;
+
+    static unsigned int acquireStage(GLenum type, const std::string& code, uint64_t& key);
+    static void releaseStage(unsigned int program, uint64_t key);
+    static void checkStage(uint64_t key, const char* type);
+    static unsigned int addProgram(Program& entry, const std::vector<std::pair<GLenum, const std::string*>>& stages);
+    static bool checkCompileErrors(unsigned int shader, std::string type);
+};
+
+#endif // PROGRAM_CACHE_H
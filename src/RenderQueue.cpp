@@ -0,0 +1,99 @@
+#include "RenderQueue.h"
+#include <algorithm>
+
+namespace {
+    const int UNUSED_BITS = 64 - 1 - RenderQueue::PASS_BITS - RenderQueue::PROGRAM_BITS -
+        RenderQueue::MATERIAL_BITS - RenderQueue::MESH_BITS - RenderQueue::DEPTH_BITS;
+    const int TRANSLUCENT_SHIFT = 64 - RenderQueue::PASS_BITS - 1;
+
+    uint64_t field(unsigned int value, int bits)
+    {
+        return (uint64_t)value & ((1ull << bits) - 1);
+    }
+}
+
+uint64_t RenderQueue::makeKey(unsigned int pass, bool translucent, unsigned int program, unsigned int material,
+    unsigned int mesh, float depth)
+{
+    const uint64_t maxDepth = (1ull << DEPTH_BITS) - 1;
+    uint64_t quantized = (uint64_t)(std::min(std::max(depth, 0.0f), 1.0f) * maxDepth);
+
+    uint64_t key = field(pass, PASS_BITS);
+    key = (key << 1) | (translucent ? 1 : 0);
+    if (translucent)
+    {
+        key = (key << DEPTH_BITS) | (maxDepth - quantized);
+        key = (key << PROGRAM_BITS) | field(program, PROGRAM_BITS);
+        key = (key << MATERIAL_BITS) | field(material, MATERIAL_BITS);
+        key = (key << MESH_BITS) | field(mesh, MESH_BITS);
+    }
+    else
+    {
+        key = (key << PROGRAM_BITS) | field(program, PROGRAM_BITS);
+        key = (key << MATERIAL_BITS) | field(material, MATERIAL_BITS);
+        key = (key << MESH_BITS) | field(mesh, MESH_BITS);
+        key = (key << DEPTH_BITS) | quantized;
+    }
+    return key << UNUSED_BITS;
+}
+
+bool RenderQueue::isTranslucent(uint64_t key)
+{
+    return (key >> TRANSLUCENT_SHIFT) & 1;
+}
+
+void RenderQueue::sort()
+{
+    m_SortPasses = 0;
+    size_t count = m_Items.size();
+    if (count < 2)
+        return;
+
+    // histograms of all eight bytes in one read of the keys
+    size_t histograms[8][256] = {};
+    for (const RenderItem& item : m_Items)
+        for (int digit = 0; digit < 8; digit++)
+            histograms[digit][(item.key >> (digit * 8)) & 0xFF]++;
+
+    m_Scratch.resize(count);
+    for (int digit = 0; digit < 8; digit++)
+    {
+        size_t* histogram = histograms[digit];
+        int shift = digit * 8;
+        // every key has the same byte here, the order would not change
+        if (histogram[(m_Items[0].key >> shift) & 0xFF] == count)
+            continue;
+
+        size_t offset = 0;
+        for (int bucket = 0; bucket < 256; bucket++)
+        {
+            size_t size = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += size;
+        }
+        for (const RenderItem& item : m_Items)
+            m_Scratch[histogram[(item.key >> shift) & 0xFF]++] = item;
+        m_Items.swap(m_Scratch);
+        m_SortPasses++;
+    }
+}
+
+void RenderQueue::buildBatches(const std::function<bool(unsigned int a, unsigned int b)>& sameDraw)
+{
+    m_Batches.clear();
+    for (int i = 0; i < (int)m_Items.size(); i++)
+    {
+        const RenderItem& item = m_Items[i];
+        if (!m_Batches.empty())
+        {
+            RenderBatch& last = m_Batches.back();
+            const RenderItem& previous = m_Items[last.first];
+            if (!isTranslucent(item.key) && !isTranslucent(previous.key) && sameDraw(previous.index, item.index))
+            {
+                last.count++;
+                continue;
+            }
+        }
+        m_Batches.push_back({ item.key, i, 1 });
+    }
+}
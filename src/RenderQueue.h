@@ -0,0 +1,68 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// One draw: its sort key and an index the caller uses to find what to draw
+struct RenderItem {
+    uint64_t key;
+    unsigned int index;
+};
+
+// Consecutive sorted items drawn with one instanced draw call
+struct RenderBatch {
+    uint64_t key;
+    int first;  // into RenderQueue::getItems()
+    int count;
+};
+
+// Draws collected for a frame and submitted in sort key order, so draws
+// sharing a program and material end up next to each other and the state
+// changes between them are few. Keys are built by makeKey, most significant
+// field first:
+//   opaque:      pass (4) | 0 | program (12) | material (16) | mesh (7) | depth (24)
+//   translucent: pass (4) | 1 | ~depth (24) | program (12) | material (16) | mesh (7)
+// Opaque draws therefore come first, grouped by state and mesh and front to
+// back within a group; translucent draws follow back to front, which
+// blending needs more than it needs fewer state changes. Items are sorted
+// with an LSD radix sort, 8 bits per pass, skipping the passes where every
+// key has the same byte. Runs of opaque items drawing the same thing are
+// then merged into instanced batches.
+class RenderQueue {
+public:
+    static const int PASS_BITS = 4;
+    static const int PROGRAM_BITS = 12;
+    static const int MATERIAL_BITS = 16;
+    static const int MESH_BITS = 7;
+    static const int DEPTH_BITS = 24;
+
+    // pass orders whole groups of draws (lower first); program, material and
+    // mesh are GL object names, only compared, so truncating them merely
+    // costs grouping; depth is the view distance scaled to [0, 1]
+    static uint64_t makeKey(unsigned int pass, bool translucent, unsigned int program, unsigned int material,
+        unsigned int mesh, float depth);
+    static bool isTranslucent(uint64_t key);
+
+    void clear() { m_Items.clear(); m_Batches.clear(); }
+    void push(uint64_t key, unsigned int index) { m_Items.push_back({ key, index }); }
+    void sort();
+    // Merges runs of sorted opaque items for which sameDraw(a, b) holds (the
+    // same mesh and material, say) into batches; every other item becomes a
+    // batch of one. Translucent items are never merged, to keep their order.
+    void buildBatches(const std::function<bool(unsigned int a, unsigned int b)>& sameDraw);
+
+    const std::vector<RenderItem>& getItems() const { return m_Items; }
+    const std::vector<RenderBatch>& getBatches() const { return m_Batches; }
+    // Radix passes the last sort() needed, out of 8
+    int getSortPasses() const { return m_SortPasses; }
+
+private:
+    std::vector<RenderItem> m_Items;
+    std::vector<RenderItem> m_Scratch;
+    std::vector<RenderBatch> m_Batches;
+    int m_SortPasses = 0;
+};
+
+#endif // RENDER_QUEUE_H
@@ -0,0 +1,195 @@
+#include "RenderTargetPool.h"
+#include "GLState.h"
+#include <algorithm>
+#include <iostream>
+
+namespace {
+    struct FormatInfo {
+        GLenum format;
+        GLenum type;
+        int bytesPerPixel;
+        GLenum attachment;
+    };
+
+    bool lookupFormat(GLenum internalFormat, FormatInfo& info)
+    {
+        switch (internalFormat)
+        {
+        case GL_RGBA8:             info = { GL_RGBA, GL_UNSIGNED_BYTE, 4, GL_COLOR_ATTACHMENT0 }; return true;
+        case GL_R8:                info = { GL_RED, GL_UNSIGNED_BYTE, 1, GL_COLOR_ATTACHMENT0 }; return true;
+        case GL_R16F:              info = { GL_RED, GL_FLOAT, 2, GL_COLOR_ATTACHMENT0 }; return true;
+        case GL_R32F:              info = { GL_RED, GL_FLOAT, 4, GL_COLOR_ATTACHMENT0 }; return true;
+        case GL_RG16F:             info = { GL_RG, GL_FLOAT, 4, GL_COLOR_ATTACHMENT0 }; return true;
+        case GL_R11F_G11F_B10F:    info = { GL_RGB, GL_FLOAT, 4, GL_COLOR_ATTACHMENT0 }; return true;
+        case GL_RGBA16F:           info = { GL_RGBA, GL_FLOAT, 8, GL_COLOR_ATTACHMENT0 }; return true;
+        case GL_RGBA32F:           info = { GL_RGBA, GL_FLOAT, 16, GL_COLOR_ATTACHMENT0 }; return true;
+        case GL_DEPTH24_STENCIL8:  info = { GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, 4, GL_DEPTH_STENCIL_ATTACHMENT }; return true;
+        case GL_DEPTH_COMPONENT32F: info = { GL_DEPTH_COMPONENT, GL_FLOAT, 4, GL_DEPTH_ATTACHMENT }; return true;
+        default: return false;
+        }
+    }
+
+    GLenum textureTarget(const RenderTargetDesc& desc)
+    {
+        return desc.samples > 1 ? GL_TEXTURE_2D_MULTISAMPLE : GL_TEXTURE_2D;
+    }
+}
+
+RenderTargetPool::~RenderTargetPool()
+{
+    while (!m_Targets.empty())
+        destroy(m_Targets.size() - 1);
+}
+
+void RenderTargetPool::beginFrame(int screenWidth, int screenHeight)
+{
+    m_Frame++;
+    m_LastRequestedBytes = m_RequestedBytes;
+    m_LastAllocations = m_Allocations;
+    m_RequestedBytes = 0;
+    m_Allocations = 0;
+
+    bool resized = screenWidth > 0 && screenHeight > 0 &&
+        (screenWidth != m_ScreenWidth || screenHeight != m_ScreenHeight);
+    if (resized)
+    {
+        m_ScreenWidth = screenWidth;
+        m_ScreenHeight = screenHeight;
+    }
+
+    for (size_t i = m_Targets.size(); i-- > 0;)
+    {
+        const PooledTarget& pooled = *m_Targets[i];
+        if (!pooled.held && (resized || m_Frame - pooled.lastUsed > UNUSED_FRAMES))
+            destroy(i);
+    }
+}
+
+const RenderTarget* RenderTargetPool::acquire(const RenderTargetDesc& desc)
+{
+    FormatInfo info;
+    if (!lookupFormat(desc.format, info) || desc.width <= 0 || desc.height <= 0)
+    {
+        std::cout << "RenderTargetPool: unsupported target 0x" << std::hex << desc.format << std::dec
+            << " " << desc.width << "x" << desc.height << std::endl;
+        return nullptr;
+    }
+
+    size_t bytes = (size_t)desc.width * desc.height * info.bytesPerPixel * (desc.samples > 1 ? desc.samples : 1);
+    m_RequestedBytes += bytes;
+
+    for (const std::unique_ptr<PooledTarget>& pooled : m_Targets)
+    {
+        if (!pooled->held && pooled->target.desc == desc)
+        {
+            pooled->held = true;
+            pooled->lastUsed = m_Frame;
+            return &pooled->target;
+        }
+    }
+
+    std::unique_ptr<PooledTarget> pooled = std::make_unique<PooledTarget>();
+    pooled->target.desc = desc;
+    pooled->target.bytes = bytes;
+    pooled->held = true;
+    pooled->lastUsed = m_Frame;
+
+    GLenum target = textureTarget(desc);
+    glGenTextures(1, &pooled->target.texture);
+    GLState::bindTexture(target, pooled->target.texture);
+    if (desc.samples > 1)
+    {
+        glTexImage2DMultisample(target, desc.samples, desc.format, desc.width, desc.height, GL_TRUE);
+    }
+    else
+    {
+        glTexImage2D(target, 0, desc.format, desc.width, desc.height, 0, info.format, info.type, NULL);
+        glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+    GLState::bindTexture(target, 0);
+
+    m_AllocatedBytes += bytes;
+    m_Allocations++;
+    m_Targets.push_back(std::move(pooled));
+    return &m_Targets.back()->target;
+}
+
+void RenderTargetPool::release(const RenderTarget* target)
+{
+    for (const std::unique_ptr<PooledTarget>& pooled : m_Targets)
+    {
+        if (&pooled->target == target)
+        {
+            pooled->held = false;
+            return;
+        }
+    }
+}
+
+unsigned int RenderTargetPool::getFramebuffer(const RenderTarget* color, const RenderTarget* depth)
+{
+    std::vector<const RenderTarget*> colors;
+    if (color)
+        colors.push_back(color);
+    return getFramebuffer(colors, depth);
+}
+
+unsigned int RenderTargetPool::getFramebuffer(const std::vector<const RenderTarget*>& colors, const RenderTarget* depth)
+{
+    std::vector<unsigned int> key;
+    for (const RenderTarget* color : colors)
+        key.push_back(color ? color->texture : 0);
+    key.push_back(depth ? depth->texture : 0);
+    auto it = m_Framebuffers.find(key);
+    if (it != m_Framebuffers.end())
+        return it->second;
+
+    unsigned int framebuffer = 0;
+    glGenFramebuffers(1, &framebuffer);
+    GLState::bindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    FormatInfo info;
+    std::vector<GLenum> drawBuffers;
+    for (const RenderTarget* color : colors)
+    {
+        if (!color || !lookupFormat(color->desc.format, info))
+            continue;
+        GLenum attachment = GL_COLOR_ATTACHMENT0 + (GLenum)drawBuffers.size();
+        glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, textureTarget(color->desc), color->texture, 0);
+        drawBuffers.push_back(attachment);
+    }
+    if (drawBuffers.empty())
+        glDrawBuffer(GL_NONE);
+    else
+        glDrawBuffers((GLsizei)drawBuffers.size(), drawBuffers.data());
+    if (depth && lookupFormat(depth->desc.format, info))
+        glFramebufferTexture2D(GL_FRAMEBUFFER, info.attachment, textureTarget(depth->desc), depth->texture, 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "RenderTargetPool: incomplete framebuffer" << std::endl;
+
+    m_Framebuffers[key] = framebuffer;
+    return framebuffer;
+}
+
+void RenderTargetPool::destroy(size_t index)
+{
+    RenderTarget& target = m_Targets[index]->target;
+    // framebuffers using the texture go with it
+    for (auto it = m_Framebuffers.begin(); it != m_Framebuffers.end();)
+    {
+        if (std::find(it->first.begin(), it->first.end(), target.texture) != it->first.end())
+        {
+            GLState::deleteFramebuffers(1, &it->second);
+            it = m_Framebuffers.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    GLState::deleteTextures(1, &target.texture);
+    m_AllocatedBytes -= target.bytes;
+    m_Targets.erase(m_Targets.begin() + index);
+}
@@ -0,0 +1,90 @@
+#ifndef RENDER_TARGET_POOL_H
+#define RENDER_TARGET_POOL_H
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+struct RenderTargetDesc {
+    GLenum format = GL_RGBA8; // sized internal format, colour or depth
+    int width = 0;
+    int height = 0;
+    int samples = 0;          // above 1 for a multisampled target
+
+    bool operator==(const RenderTargetDesc& other) const
+    {
+        return format == other.format && width == other.width && height == other.height && samples == other.samples;
+    }
+};
+
+struct RenderTarget {
+    unsigned int texture = 0; // GL_TEXTURE_2D, or GL_TEXTURE_2D_MULTISAMPLE when desc.samples > 1
+    RenderTargetDesc desc;
+    size_t bytes = 0;
+};
+
+// Hands out the textures passes render into for the length of a frame.
+// A target released by one pass is handed to the next pass asking for the
+// same format, size and sample count, so passes whose lifetimes don't
+// overlap share memory. The screen size is tracked per frame: when it
+// changes, every target that is not held is freed and later requests
+// allocate at the new size; targets nobody asked for in a few frames are
+// freed as well. Framebuffers for target combinations are cached.
+class RenderTargetPool {
+public:
+    RenderTargetPool() = default;
+    ~RenderTargetPool();
+
+    RenderTargetPool(const RenderTargetPool&) = delete;
+    RenderTargetPool& operator=(const RenderTargetPool&) = delete;
+
+    // Once per frame before any pass acquires; a 0x0 (minimised) screen
+    // keeps the previous size
+    void beginFrame(int screenWidth, int screenHeight);
+
+    // A target matching desc that no other pass holds, allocated if needed;
+    // it stays valid until released
+    const RenderTarget* acquire(const RenderTargetDesc& desc);
+    // Hands the target back; its contents may be overwritten by the next acquire
+    void release(const RenderTarget* target);
+
+    // A complete framebuffer with these attachments, either may be null
+    unsigned int getFramebuffer(const RenderTarget* color, const RenderTarget* depth = nullptr);
+    // The same with colors as draw buffers 0, 1, ...
+    unsigned int getFramebuffer(const std::vector<const RenderTarget*>& colors, const RenderTarget* depth);
+
+    int getScreenWidth() const { return m_ScreenWidth; }
+    int getScreenHeight() const { return m_ScreenHeight; }
+    int getTargetCount() const { return (int)m_Targets.size(); }
+    // VRAM held by the pool now
+    size_t getAllocatedBytes() const { return m_AllocatedBytes; }
+    // What the previous frame's targets would have taken with one texture per acquire
+    size_t getRequestedBytes() const { return m_LastRequestedBytes; }
+    size_t getSavedBytes() const { return m_LastRequestedBytes > m_AllocatedBytes ? m_LastRequestedBytes - m_AllocatedBytes : 0; }
+    int getAllocationsLastFrame() const { return m_LastAllocations; }
+
+private:
+    static const unsigned int UNUSED_FRAMES = 3;
+
+    struct PooledTarget {
+        RenderTarget target;
+        bool held = false;
+        unsigned int lastUsed = 0;
+    };
+
+    std::vector<std::unique_ptr<PooledTarget>> m_Targets;
+    // keyed by the colour textures in order, then the depth texture
+    std::map<std::vector<unsigned int>, unsigned int> m_Framebuffers;
+    int m_ScreenWidth = 0, m_ScreenHeight = 0;
+    unsigned int m_Frame = 0;
+    size_t m_AllocatedBytes = 0;
+    size_t m_RequestedBytes = 0, m_LastRequestedBytes = 0;
+    int m_Allocations = 0, m_LastAllocations = 0;
+
+    void destroy(size_t index);
+};
+
+#endif // RENDER_TARGET_POOL_H
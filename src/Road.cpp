@@ -1,4 +1,5 @@
 #include "Road.h"
+#include "GLState.h"
 #include "Terrain.h"
 #include <glad/glad.h>
 #include <glm/gtc/type_ptr.hpp>
@@ -31,7 +32,7 @@ void Road::setupBuffers() {
     glGenVertexArrays(1, &VAO);
     glGenBuffers(1, &VBO);
 
-    glBindVertexArray(VAO);
+    GLState::bindVertexArray(VAO);
 
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
     glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
@@ -40,15 +41,14 @@ void Road::setupBuffers() {
     glEnableVertexAttribArray(0);
 
     glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    GLState::bindVertexArray(0);
 }
 
 void Road::render() const {
     if (VAO == 0) return; // Ensure buffers are set up
 
-    glBindVertexArray(VAO);
+    GLState::bindVertexArray(VAO);
     glDrawArrays(GL_LINE_STRIP, 0, vertices.size() / 3);
-    glBindVertexArray(0);
 }
 
 const std::vector<glm::vec3>& Road::getPath() const {
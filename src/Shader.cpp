@@ -1,109 +1,320 @@
 #include "Shader.h"
+#include "FrameUniforms.h"
+#include "GLExtensions.h"
+#include "GLState.h"
+#include "ProgramCache.h"
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <chrono>
+#include <algorithm>
+#include <filesystem>
 
-Shader::Shader(const char* vertexPath, const char* fragmentPath)
+unsigned int Shader::s_locationQueries = 0;
+
+namespace {
+    // retrieve the source code from filePath
+    bool readShaderFile(const std::string& path, std::string& code)
+    {
+        std::ifstream shaderFile;
+        // ensure ifstream objects can throw exceptions:
+        shaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+        try
+        {
+            shaderFile.open(path);
+            std::stringstream shaderStream;
+            shaderStream << shaderFile.rdbuf();
+            shaderFile.close();
+            code = shaderStream.str();
+            return true;
+        }
+        catch (std::ifstream::failure& e)
+        {
+            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << path << std::endl;
+            return false;
+        }
+    }
+
+    // insert "#define KEY" lines right after the #version directive
+    void injectDefines(std::string& code, const std::vector<std::string>& defines)
+    {
+        if (defines.empty())
+            return;
+
+        size_t insertAt = 0;
+        size_t version = code.find("#version");
+        if (version != std::string::npos)
+        {
+            size_t lineEnd = code.find('\n', version);
+            insertAt = lineEnd == std::string::npos ? code.size() : lineEnd + 1;
+        }
+
+        std::string block;
+        for (const std::string& define : defines)
+            block += "#define " + define + "\n";
+        // keep compiler error line numbers matching the file
+        block += "#line " + std::to_string(std::count(code.begin(), code.begin() + insertAt, '\n') + 1) + "\n";
+        code.insert(insertAt, block);
+    }
+}
+
+int Shader::s_BatchDepth = 0;
+std::vector<Shader*> Shader::s_Batch;
+
+Shader::Shader(const char* vertexPath, const char* fragmentPath, const std::vector<std::string>& defines)
+    : ID(0), m_VertexPath(vertexPath), m_FragmentPath(fragmentPath), m_Defines(defines), m_PendingID(0), m_PendingPolls(0)
 {
-    // 1. retrieve the vertex/fragment source code from filePath
-    std::string vertexCode;
-    std::string fragmentCode;
-    std::ifstream vShaderFile;
-    std::ifstream fShaderFile;
-    // ensure ifstream objects can throw exceptions:
-    vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    try
+    build();
+}
+
+Shader::Shader(const char* computePath, const std::vector<std::string>& defines)
+    : ID(0), m_ComputePath(computePath), m_Defines(defines), m_PendingID(0), m_PendingPolls(0)
+{
+    build();
+}
+
+void Shader::build()
+{
+    auto startTime = std::chrono::steady_clock::now();
+
+    // 1. retrieve the source code from the files and 2. fetch the program
+    // from the cache, which submits it if it is new
+    ID = submitProgram(false);
+    if (s_BatchDepth > 0)
     {
-        // open files
-        vShaderFile.open(vertexPath);
-        fShaderFile.open(fragmentPath);
-        std::stringstream vShaderStream, fShaderStream;
-        // read file's buffer contents into streams
-        vShaderStream << vShaderFile.rdbuf();
-        fShaderStream << fShaderFile.rdbuf();
-        // close file handlers
-        vShaderFile.close();
-        fShaderFile.close();
-        // convert stream into string
-        vertexCode = vShaderStream.str();
-        fragmentCode = fShaderStream.str();
+        // status is queried for the whole batch in endBatch()
+        s_Batch.push_back(this);
+        return;
     }
-    catch (std::ifstream::failure& e)
+
+    // 3. wait for the link
+    finishBuild();
+
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - startTime;
+    std::cout << "Shader " << describe()
+        << (ProgramCache::wasLoadedFromDisk(ID) ? ": loaded from program binary cache in " : ": ready in ")
+        << elapsed.count() << " ms" << std::endl;
+}
+
+unsigned int Shader::submitProgram(bool requireFiles) const
+{
+    if (!m_ComputePath.empty())
     {
-        std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ" << std::endl;
+        std::string computeCode;
+        if (!readShaderFile(m_ComputePath, computeCode) && requireFiles)
+            return 0;
+        injectDefines(computeCode, m_Defines);
+        return ProgramCache::acquireCompute(computeCode);
     }
-    const char* vShaderCode = vertexCode.c_str();
-    const char* fShaderCode = fragmentCode.c_str();
-    // 2. compile shaders
-    unsigned int vertex, fragment;
-    // vertex shader
-    vertex = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex, 1, &vShaderCode, NULL);
-    glCompileShader(vertex);
-    checkCompileErrors(vertex, "VERTEX");
-    // fragment Shader
-    fragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment, 1, &fShaderCode, NULL);
-    glCompileShader(fragment);
-    checkCompileErrors(fragment, "FRAGMENT");
-    // shader Program
-    ID = glCreateProgram();
-    glAttachShader(ID, vertex);
-    glAttachShader(ID, fragment);
-    glLinkProgram(ID);
-    checkCompileErrors(ID, "PROGRAM");
-    // delete the shaders as they're linked into our program now and no longer necessary
-    glDeleteShader(vertex);
-    glDeleteShader(fragment);
+
+    std::string vertexCode;
+    std::string fragmentCode;
+    bool filesRead = readShaderFile(m_VertexPath, vertexCode);
+    filesRead = readShaderFile(m_FragmentPath, fragmentCode) && filesRead;
+    if (!filesRead && requireFiles)
+        return 0;
+    injectDefines(vertexCode, m_Defines);
+    injectDefines(fragmentCode, m_Defines);
+    return ProgramCache::acquire(vertexCode, fragmentCode);
 }
 
-void Shader::use()
+std::string Shader::describe() const
 {
-    glUseProgram(ID);
+    return m_ComputePath.empty() ? m_VertexPath + " / " + m_FragmentPath : m_ComputePath;
 }
 
-void Shader::setBool(const std::string& name, bool value) const
+Shader::~Shader()
 {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+    s_Batch.erase(std::remove(s_Batch.begin(), s_Batch.end(), this), s_Batch.end());
+    cancelReload();
+    ProgramCache::release(ID);
 }
-void Shader::setInt(const std::string& name, int value) const
+
+void Shader::beginBatch()
 {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+    s_BatchDepth++;
 }
-void Shader::setFloat(const std::string& name, float value) const
+
+void Shader::endBatch()
 {
-    glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+    if (s_BatchDepth == 0 || --s_BatchDepth > 0)
+        return;
+
+    auto startTime = std::chrono::steady_clock::now();
+    std::vector<Shader*> batch;
+    batch.swap(s_Batch);
+    for (Shader* shader : batch)
+        shader->finishBuild();
+
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - startTime;
+    std::cout << "Shader batch: " << batch.size() << " shaders, " << ProgramCache::getProgramCount()
+        << " unique programs, ready after " << elapsed.count() << " ms of waiting" << std::endl;
 }
-void Shader::setVec3(const std::string& name, const glm::vec3& value) const
+
+void Shader::finishBuild()
+{
+    ProgramCache::finish(ID);
+    buildUniformTable();
+    bindUniformBlocks();
+}
+
+bool Shader::usesFile(const std::string& path) const
 {
-    glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+    std::filesystem::path changed = std::filesystem::path(path).lexically_normal();
+    if (!m_ComputePath.empty())
+        return changed == std::filesystem::path(m_ComputePath).lexically_normal();
+    return changed == std::filesystem::path(m_VertexPath).lexically_normal() ||
+        changed == std::filesystem::path(m_FragmentPath).lexically_normal();
 }
-void Shader::setMat4(const std::string& name, const glm::mat4& mat) const
+
+void Shader::beginReload()
 {
-    glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    // a newer edit supersedes a reload that is still compiling
+    cancelReload();
+
+    m_PendingID = submitProgram(true);
+    m_PendingPolls = 0;
 }
 
-void Shader::checkCompileErrors(unsigned int shader, std::string type)
+bool Shader::pollReload()
 {
-    int success;
-    char infoLog[1024];
-    if (type != "PROGRAM")
+    if (m_PendingID == 0)
+        return false;
+
+    if (GLExt::hasParallelShaderCompile)
     {
-        glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-        if (!success)
-        {
-            glGetShaderInfoLog(shader, 1024, NULL, infoLog);
-            std::cout << "ERROR::SHADER_COMPILATION_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
-        }
+        if (!ProgramCache::isComplete(m_PendingID))
+            return false;
     }
-    else
+    else if (m_PendingPolls++ == 0)
     {
-        glGetProgramiv(shader, GL_LINK_STATUS, &success);
-        if (!success)
-        {
-            glGetProgramInfoLog(shader, 1024, NULL, infoLog);
-            std::cout << "ERROR::PROGRAM_LINKING_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
-        }
+        // Without the extension every status query may block until the
+        // driver is done, so there is no way to ask. Give it a frame, then
+        // accept one stall in finish() if it is still compiling or linking.
+        return false;
+    }
+
+    if (!ProgramCache::finish(m_PendingID))
+    {
+        std::cout << "Shader " << describe() << ": reload failed, keeping previous program" << std::endl;
+        cancelReload();
+        return false;
+    }
+
+    ProgramCache::release(ID);
+    ID = m_PendingID;
+    m_PendingID = 0;
+    buildUniformTable();
+    bindUniformBlocks();
+    std::cout << "Shader " << describe() << ": reloaded" << std::endl;
+    return true;
+}
+
+void Shader::cancelReload()
+{
+    if (m_PendingID == 0)
+        return;
+    ProgramCache::release(m_PendingID);
+    m_PendingID = 0;
+}
+
+void Shader::use()
+{
+    GLState::useProgram(ID);
+}
+
+void Shader::buildUniformTable()
+{
+    m_uniforms.clear();
+
+    int count = 0, maxLength = 0;
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    std::vector<char> nameBuffer(maxLength > 0 ? maxLength : 1);
+
+    for (int i = 0; i < count; i++)
+    {
+        int length = 0, size = 0;
+        GLenum type;
+        glGetActiveUniform(ID, i, maxLength, &length, &size, &type, nameBuffer.data());
+        std::string name(nameBuffer.data(), length);
+
+        int location = glGetUniformLocation(ID, name.c_str());
+        s_locationQueries++;
+        if (location < 0)
+            continue; // uniform block member, not settable through glUniform*
+
+        // arrays are reported as "name[0]"; make the bare name resolve too
+        if (size > 1 && name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+            m_uniforms.push_back({ hashUniformName(std::string_view(name).substr(0, name.size() - 3)), location, name.substr(0, name.size() - 3) });
+        m_uniforms.push_back({ hashUniformName(name), location, name });
     }
-}
\ No newline at end of file
+}
+
+void Shader::bindUniformBlocks()
+{
+    // GLSL 330 has no layout(binding = N), so shared blocks are bound here
+    unsigned int frameData = glGetUniformBlockIndex(ID, "FrameData");
+    if (frameData != GL_INVALID_INDEX)
+        glUniformBlockBinding(ID, frameData, FRAME_DATA_BINDING);
+}
+
+int Shader::getUniformLocation(std::string_view name) const
+{
+    uint32_t hash = hashUniformName(name);
+    for (const auto& entry : m_uniforms)
+    {
+        if (entry.hash == hash && entry.name == name)
+            return entry.location;
+    }
+
+    // not an active uniform name (array element, typo or optimised out):
+    // ask the driver once and remember the answer, including -1
+    int location = glGetUniformLocation(ID, std::string(name).c_str());
+    s_locationQueries++;
+    m_uniforms.push_back({ hash, location, std::string(name) });
+    return location;
+}
+
+int Shader::getUniformLocation(UniformId id) const
+{
+    for (const auto& entry : m_uniforms)
+    {
+        if (entry.hash == id.hash)
+            return entry.location;
+    }
+    return -1;
+}
+
+void Shader::setBool(int location, bool value) const
+{
+    glUniform1i(location, (int)value);
+}
+void Shader::setInt(int location, int value) const
+{
+    glUniform1i(location, value);
+}
+void Shader::setFloat(int location, float value) const
+{
+    glUniform1f(location, value);
+}
+void Shader::setVec2(int location, const glm::vec2& value) const
+{
+    glUniform2fv(location, 1, &value[0]);
+}
+void Shader::setVec3(int location, const glm::vec3& value) const
+{
+    glUniform3fv(location, 1, &value[0]);
+}
+void Shader::setVec4(int location, const glm::vec4& value) const
+{
+    glUniform4fv(location, 1, &value[0]);
+}
+void Shader::setMat4(int location, const glm::mat4& mat) const
+{
+    glUniformMatrix4fv(location, 1, GL_FALSE, &mat[0][0]);
+}
+void Shader::setFloatArray(int location, const float* values, int count) const
+{
+    glUniform1fv(location, count, values);
+}
@@ -0,0 +1,54 @@
+#include "ShaderVariants.h"
+#include <iostream>
+
+ShaderVariants::ShaderVariants(const char* vertexPath, const char* fragmentPath, const std::vector<std::string>& keys)
+    : m_VertexPath(vertexPath), m_FragmentPath(fragmentPath), m_Keys(keys)
+{
+    if (m_Keys.size() > 16)
+    {
+        std::cout << "ShaderVariants: too many keys for " << fragmentPath << ", only the first 16 are used" << std::endl;
+        m_Keys.resize(16);
+    }
+}
+
+Shader& ShaderVariants::get(uint32_t mask)
+{
+    // ignore bits that have no key so the table stays bounded
+    mask &= (uint32_t)getMaxVariantCount() - 1;
+
+    auto it = m_Programs.find(mask);
+    if (it != m_Programs.end())
+        return *it->second;
+
+    std::vector<std::string> defines;
+    std::string names;
+    for (size_t i = 0; i < m_Keys.size(); i++)
+    {
+        if (mask & (1u << i))
+        {
+            defines.push_back(m_Keys[i]);
+            names += (names.empty() ? "" : " ") + m_Keys[i];
+        }
+    }
+    std::cout << "ShaderVariants: building variant " << mask << " of " << m_FragmentPath
+        << " (" << (names.empty() ? "no defines" : names) << ")" << std::endl;
+
+    Shader* shader = new Shader(m_VertexPath.c_str(), m_FragmentPath.c_str(), defines);
+    m_Programs[mask] = std::unique_ptr<Shader>(shader);
+    return *shader;
+}
+
+void ShaderVariants::onFileChanged(const std::string& path)
+{
+    for (auto& program : m_Programs)
+    {
+        if (program.second->usesFile(path))
+            program.second->beginReload();
+    }
+}
+
+void ShaderVariants::pollReload()
+{
+    for (auto& program : m_Programs)
+        program.second->pollReload();
+}
@@ -0,0 +1,35 @@
+#ifndef SHADER_VARIANTS_H
+#define SHADER_VARIANTS_H
+
+#include "Shader.h"
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// One vertex/fragment source pair compiled into several programs, one per
+// combination of feature keys. Bit i of a variant mask enables keys[i] as a
+// #define. Variants are compiled the first time they are requested, so only
+// combinations that are actually drawn ever exist.
+class ShaderVariants {
+public:
+    ShaderVariants(const char* vertexPath, const char* fragmentPath, const std::vector<std::string>& keys);
+
+    Shader& get(uint32_t mask);
+
+    size_t getVariantCount() const { return m_Programs.size(); }
+    size_t getMaxVariantCount() const { return size_t(1) << m_Keys.size(); }
+
+    // Forwards hot reload to every compiled variant
+    void onFileChanged(const std::string& path);
+    void pollReload();
+
+private:
+    std::string m_VertexPath;
+    std::string m_FragmentPath;
+    std::vector<std::string> m_Keys;
+    std::map<uint32_t, std::unique_ptr<Shader>> m_Programs;
+};
+
+#endif // SHADER_VARIANTS_H
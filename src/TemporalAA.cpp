@@ -0,0 +1,110 @@
+#include "TemporalAA.h"
+#include "FullscreenQuad.h"
+#include "GLState.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    float halton(unsigned int index, unsigned int base) {
+        float result = 0.0f;
+        float fraction = 1.0f / base;
+        for (; index > 0; index /= base, fraction /= base)
+            result += fraction * (index % base);
+        return result;
+    }
+}
+
+TemporalAA::TemporalAA(RenderTargetPool& pool)
+    : m_Pool(pool), m_ResolveShader("Shaders/fullscreen.vert", "Shaders/taa_resolve.frag"),
+    m_Current(0), m_HistoryValid(false), m_Frame(0), m_JitterPhases(BASE_JITTER_PHASES), m_JitterPixels(0.0f) {
+    m_History[0] = m_History[1] = nullptr;
+}
+
+TemporalAA::~TemporalAA() {
+    releaseHistory();
+}
+
+void TemporalAA::releaseHistory() {
+    for (const RenderTarget*& history : m_History) {
+        if (history)
+            m_Pool.release(history);
+        history = nullptr;
+    }
+    m_HistoryValid = false;
+}
+
+glm::vec2 TemporalAA::beginFrame(const TemporalAASettings& settings, int sceneWidth, int sceneHeight, int outputWidth, int outputHeight) {
+    if (!settings.enabled || sceneWidth <= 0 || sceneHeight <= 0) {
+        releaseHistory();
+        m_JitterPixels = glm::vec2(0.0f);
+        return m_JitterPixels;
+    }
+
+    RenderTargetDesc desc;
+    desc.format = GL_RGBA16F;
+    desc.width = outputWidth;
+    desc.height = outputHeight;
+    if (m_History[0] && !(m_History[0]->desc == desc))
+        releaseHistory();
+    if (!m_History[0]) {
+        m_History[0] = m_Pool.acquire(desc);
+        m_History[1] = m_Pool.acquire(desc);
+        m_HistoryValid = false;
+    }
+
+    // an output pixel covers upscale^2 scene pixels' worth of jitter positions
+    float upscale = (float)outputWidth * outputHeight / ((float)sceneWidth * sceneHeight);
+    m_JitterPhases = std::min(std::max((int)std::ceil(BASE_JITTER_PHASES * upscale), BASE_JITTER_PHASES), MAX_JITTER_PHASES);
+    unsigned int index = m_Frame++ % m_JitterPhases + 1;
+    m_JitterPixels = glm::vec2(halton(index, 2), halton(index, 3)) - 0.5f;
+    return m_JitterPixels * 2.0f / glm::vec2((float)sceneWidth, (float)sceneHeight);
+}
+
+FrameResource TemporalAA::addPass(FrameGraph& graph, FrameResource color, FrameResource velocity, FrameResource depth,
+    const TemporalAASettings& settings) {
+    if (!m_History[0] || !m_History[1])
+        return color;
+
+    FrameResource previous = graph.importTexture("TAA history", m_History[1 - m_Current]);
+    FrameResource resolved = graph.importTexture("TAA resolved", m_History[m_Current]);
+    bool historyValid = m_HistoryValid;
+    glm::vec2 jitterPixels = m_JitterPixels;
+    graph.addPass("TAA resolve",
+        [&](FrameGraph::Builder& pass) {
+            pass.read(color);
+            pass.read(velocity);
+            pass.read(depth);
+            pass.read(previous);
+            pass.writeColor(resolved);
+        },
+        [this, &graph, color, velocity, depth, previous, historyValid, jitterPixels, settings]() {
+            GLState::disable(GL_DEPTH_TEST);
+            GLState::disable(GL_BLEND);
+            GLState::polygonMode(GL_FRONT_AND_BACK, GL_FILL);
+            m_ResolveShader.use();
+            m_ResolveShader.setInt("sceneColor"_u, 0);
+            m_ResolveShader.setInt("sceneVelocity"_u, 1);
+            m_ResolveShader.setInt("sceneDepth"_u, 2);
+            m_ResolveShader.setInt("history"_u, 3);
+            m_ResolveShader.setBool("historyValid"_u, historyValid);
+            m_ResolveShader.setVec2("jitter"_u, jitterPixels);
+            m_ResolveShader.setFloat("blend"_u, settings.blend);
+            m_ResolveShader.setFloat("clipGamma"_u, settings.clipGamma);
+            FrameResource inputs[] = { color, velocity, depth, previous };
+            for (int unit = 0; unit < 4; unit++) {
+                GLState::activeTexture(GL_TEXTURE0 + unit);
+                GLState::bindTexture(GL_TEXTURE_2D, graph.getTexture(inputs[unit]));
+            }
+            GLState::activeTexture(GL_TEXTURE0);
+            drawFullscreenQuad();
+            GLState::enable(GL_DEPTH_TEST);
+            m_HistoryValid = true;
+        });
+    m_Current = 1 - m_Current;
+    return resolved;
+}
+
+void TemporalAA::onFileChanged(const std::string& path) {
+    if (m_ResolveShader.usesFile(path))
+        m_ResolveShader.beginReload();
+}
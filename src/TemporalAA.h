@@ -0,0 +1,70 @@
+#ifndef TEMPORAL_AA_H
+#define TEMPORAL_AA_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <string>
+#include "FrameGraph.h"
+#include "RenderTargetPool.h"
+#include "Shader.h"
+
+struct TemporalAASettings {
+    bool enabled = true;
+    // weight of the new frame where its sample lands on the output pixel
+    float blend = 0.1f;
+    // half-size of the colour box history is clipped to, in standard deviations
+    float clipGamma = 1.0f;
+};
+
+// Temporal anti-aliasing. Every frame the projection is shifted by a
+// sub-pixel offset from a Halton(2, 3) sequence, so over a few frames each
+// pixel is sampled at many positions. The resolve reprojects the
+// accumulated history with the velocity buffer (taking the velocity of the
+// nearest surface around the pixel, so edges move with their foreground),
+// clips it to the colour range of the current neighbourhood to reject
+// stale samples, and blends in the current frame. The history is kept at
+// output resolution: a scene rendered smaller is upscaled by the same
+// pass, each output pixel taking the current sample in proportion to how
+// close it landed, with longer jitter sequences so every output pixel is
+// eventually covered.
+class TemporalAA {
+public:
+    explicit TemporalAA(RenderTargetPool& pool);
+    ~TemporalAA();
+
+    TemporalAA(const TemporalAA&) = delete;
+    TemporalAA& operator=(const TemporalAA&) = delete;
+
+    // Advances the jitter sequence and returns the NDC offset to render this
+    // frame with (zero when disabled). Call after the pool's beginFrame.
+    glm::vec2 beginFrame(const TemporalAASettings& settings, int sceneWidth, int sceneHeight, int outputWidth, int outputHeight);
+
+    // Adds the resolve pass and returns the anti-aliased HDR image at output
+    // resolution. velocity is the scene pass's RG16F motion in UV units.
+    FrameResource addPass(FrameGraph& graph, FrameResource color, FrameResource velocity, FrameResource depth,
+        const TemporalAASettings& settings);
+
+    int getJitterPhases() const { return m_JitterPhases; }
+    glm::vec2 getJitterPixels() const { return m_JitterPixels; }
+
+    void onFileChanged(const std::string& path);
+    void pollReload() { m_ResolveShader.pollReload(); }
+
+private:
+    static const int BASE_JITTER_PHASES = 8;
+    static const int MAX_JITTER_PHASES = 64;
+
+    RenderTargetPool& m_Pool;
+    Shader m_ResolveShader;
+    // held from the pool across frames; the resolve reads one and writes the other
+    const RenderTarget* m_History[2];
+    int m_Current;
+    bool m_HistoryValid;
+    unsigned int m_Frame;
+    int m_JitterPhases;
+    glm::vec2 m_JitterPixels;
+
+    void releaseHistory();
+};
+
+#endif // TEMPORAL_AA_H
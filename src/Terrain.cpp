@@ -1,4 +1,5 @@
 #include "Terrain.h"
+#include "GLState.h"
 #include <glm/gtc/noise.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
@@ -78,7 +79,7 @@ void Terrain::setupMesh() {
     glGenBuffers(1, &VBO);
     glGenBuffers(1, &EBO);
 
-    glBindVertexArray(VAO);
+    GLState::bindVertexArray(VAO);
 
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
     glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
@@ -95,13 +96,12 @@ void Terrain::setupMesh() {
     glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
     glEnableVertexAttribArray(2);
 
-    glBindVertexArray(0);
+    GLState::bindVertexArray(0);
 }
 
 void Terrain::draw() {
-    glBindVertexArray(VAO);
+    GLState::bindVertexArray(VAO);
     glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
 }
 
 void Terrain::carveRoad(const std::vector<glm::vec3>& roadPath, float roadWidth) {
@@ -1,4 +1,5 @@
 #include "TerrainPlane.h"
+#include "GLState.h"
 #include <glm/gtc/matrix_transform.hpp>
 
 TerrainPlane::TerrainPlane(int width, int height) : width(width), height(height) {
@@ -7,7 +8,7 @@ TerrainPlane::TerrainPlane(int width, int height) : width(width), height(height)
 }
 
 TerrainPlane::~TerrainPlane() {
-    glDeleteVertexArrays(1, &VAO);
+    GLState::deleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
     glDeleteBuffers(1, &EBO);
 }
@@ -48,7 +49,7 @@ void TerrainPlane::setupBuffers() {
     glGenBuffers(1, &VBO);
     glGenBuffers(1, &EBO);
 
-    glBindVertexArray(VAO);
+    GLState::bindVertexArray(VAO);
 
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
     glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
@@ -60,11 +61,10 @@ void TerrainPlane::setupBuffers() {
     glEnableVertexAttribArray(0);
 
     glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    GLState::bindVertexArray(0);
 }
 
 void TerrainPlane::render() {
-    glBindVertexArray(VAO);
+    GLState::bindVertexArray(VAO);
     glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
 }
\ No newline at end of file
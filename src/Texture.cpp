@@ -1,45 +1,373 @@
 #include "Texture.h"
+#include "GLExtensions.h"
+#include "GLState.h"
+#include "TextureLoader.h"
 #include "stb_image.h"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
 #include <iostream>
 
-Texture::Texture(const std::string& path)
-    : m_RendererID(0), m_FilePath(path), m_LocalBuffer(nullptr),
-    m_Width(0), m_Height(0), m_BPP(0)
+bool isBlockFormatSupported(BlockFormat format)
 {
-    stbi_set_flip_vertically_on_load(1);
-    m_LocalBuffer = stbi_load(path.c_str(), &m_Width, &m_Height, &m_BPP, 4);
+    switch (format)
+    {
+    case BlockFormat::BC1:
+    case BlockFormat::BC3:
+        return GLExt::hasTextureCompressionS3TC;
+    case BlockFormat::BC5:
+        return true;
+    case BlockFormat::BC7:
+        return GLExt::hasTextureCompressionBPTC;
+    }
+    return false;
+}
+
+namespace {
+    bool decodeCompressed(const std::string& path, TextureImage& image)
+    {
+        CompressedImage container;
+        if (!readTextureContainer(path, container))
+        {
+            std::cout << "Invalid compressed texture: " << path << std::endl;
+            return false;
+        }
+        if (container.layers != 1)
+        {
+            std::cout << path << " has " << container.layers << " layers; load it as a TextureArray" << std::endl;
+            return false;
+        }
+        if (!isBlockFormatSupported(container.format))
+        {
+            std::cout << blockFormatName(container.format) << " is not supported by the driver, skipping " << path << std::endl;
+            return false;
+        }
+
+        image.internalFormat = container.glInternalFormat;
+        image.compressed = true;
+        image.generateMips = false;
+        image.width = container.width;
+        image.height = container.height;
+        image.mipCount = (int)container.levels.size();
+        image.levels.clear();
+        for (CompressedLevel& level : container.levels)
+            image.levels.push_back({ level.width, level.height, std::move(level.data) });
+        return true;
+    }
 
-    if (m_LocalBuffer)
+    bool decodeImage(const std::string& path, const TextureOptions& options, bool partial, TextureImage& image)
     {
-        glGenTextures(1, &m_RendererID);
-        glBindTexture(GL_TEXTURE_2D, m_RendererID);
+        // the thread-local setting, so concurrent decodes on loader threads don't race
+        stbi_set_flip_vertically_on_load_thread(1);
+        int width = 0, height = 0, channels = 0;
+        unsigned char* pixels = stbi_load(path.c_str(), &width, &height, &channels, 4);
+        if (!pixels)
+            return false;
 
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        //glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        //glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        // the GPU can only build a chain from level 0, so part of a chain is built here
+        MipSource mips = options.mips;
+        if (mips == MipSource::GPU && partial)
+            mips = MipSource::CPUBox;
 
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_Width, m_Height, 0, GL_RGBA, GL_UNSIGNED_BYTE, m_LocalBuffer);
-        glBindTexture(GL_TEXTURE_2D, 0);
+        image.internalFormat = GL_RGBA8;
+        image.compressed = false;
+        image.generateMips = mips == MipSource::GPU;
+        image.width = width;
+        image.height = height;
+        if (mips == MipSource::CPUBox || mips == MipSource::CPUKaiser)
+        {
+            MipFilter filter = mips == MipSource::CPUBox ? MipFilter::Box : MipFilter::Kaiser;
+            image.levels = generateMipChain(pixels, width, height, filter);
+        }
+        else
+        {
+            image.levels.clear();
+            image.levels.push_back({ width, height, std::vector<unsigned char>(pixels, pixels + (size_t)width * height * 4) });
+        }
+        image.mipCount = image.generateMips ? 1 + (int)floor(log2(std::max(width, height))) : (int)image.levels.size();
 
-        glBindTexture(GL_TEXTURE_2D, 0);
-        stbi_image_free(m_LocalBuffer);
+        stbi_image_free(pixels);
+        return true;
     }
-    else
+
+    // Creates and fills levels [image.baseLevel, image.baseLevel + levels) of id
+    size_t uploadLevels(unsigned int id, const TextureImage& image)
     {
-        std::cout << "Failed to load texture: " << path << std::endl;
+        size_t bytes = 0;
+        GLState::bindTexture(GL_TEXTURE_2D, id);
+        for (size_t level = 0; level < image.levels.size(); level++)
+        {
+            const MipLevel& data = image.levels[level];
+            GLint target = (GLint)(image.baseLevel + level);
+            if (image.compressed)
+                glCompressedTexImage2D(GL_TEXTURE_2D, target, image.internalFormat, data.width, data.height, 0,
+                    (GLsizei)data.pixels.size(), data.pixels.data());
+            else
+                glTexImage2D(GL_TEXTURE_2D, target, image.internalFormat, data.width, data.height, 0,
+                    GL_RGBA, GL_UNSIGNED_BYTE, data.pixels.data());
+            bytes += data.pixels.size();
+        }
+        GLState::bindTexture(GL_TEXTURE_2D, 0);
+        return bytes;
     }
 }
 
+bool decodeTexture(const std::string& path, const TextureOptions& options, TextureImage& image, int levelCount)
+{
+    std::filesystem::path file(path);
+    std::filesystem::path cooked = std::filesystem::path(file).replace_extension(".bct");
+    std::error_code ec;
+    bool partial = options.skipLevels > 0 || levelCount > 0;
+    bool decoded = false;
+    if (file.extension() == ".bct")
+        decoded = decodeCompressed(path, image);
+    else if (options.preferCompressed && std::filesystem::exists(cooked, ec) && decodeCompressed(cooked.string(), image))
+        decoded = true;
+    else
+        decoded = decodeImage(path, options, partial, image);
+    if (!decoded)
+        return false;
+
+    int skip = std::min(options.skipLevels, (int)image.levels.size() - 1);
+    if (skip > 0)
+        image.levels.erase(image.levels.begin(), image.levels.begin() + skip);
+    image.baseLevel = std::max(skip, 0);
+    if (levelCount > 0 && (int)image.levels.size() > levelCount)
+        image.levels.resize(levelCount);
+    return true;
+}
+
+size_t TextureInfo::levelBytes(int level) const
+{
+    size_t w = (size_t)std::max(width >> level, 1);
+    size_t h = (size_t)std::max(height >> level, 1);
+    if (compressed)
+        return ((w + 3) / 4) * ((h + 3) / 4) * unitBytes;
+    return w * h * unitBytes;
+}
+
+void describeTexture(const TextureImage& image, TextureInfo& info)
+{
+    const MipLevel& first = image.levels[0];
+    size_t units = image.compressed ? (size_t)((first.width + 3) / 4) * ((first.height + 3) / 4) : (size_t)first.width * first.height;
+    info.width = image.width;
+    info.height = image.height;
+    info.mipCount = image.mipCount;
+    info.compressed = image.compressed;
+    info.unitBytes = first.pixels.size() / units;
+}
+
+unsigned int Texture::s_CurrentFrame = 0;
+
+Texture::Texture(const std::string& path, const TextureOptions& options)
+    : m_RendererID(0), m_FilePath(path), m_Options(options), m_LastUsedFrame(s_CurrentFrame),
+    m_RequestedLevel(0), m_RequestedFrame(s_CurrentFrame)
+{
+    load();
+}
+
 Texture::~Texture()
 {
-    glDeleteTextures(1, &m_RendererID);
+    // the loader skips requests whose texture has gone away
+    if (m_Request)
+        m_Request->cancelled = true;
+    GLState::deleteTextures(1, &m_RendererID);
+}
+
+void Texture::load()
+{
+    unsigned int id = 0;
+    glGenTextures(1, &id);
+
+    if (m_Options.loader)
+    {
+        m_RendererID = id;
+        m_Request = m_Options.loader->request(m_RendererID, m_FilePath, m_Options);
+        return;
+    }
+
+    TextureImage image;
+    if (!decodeTexture(m_FilePath, m_Options, image))
+    {
+        std::cout << "Failed to load texture: " << m_FilePath << std::endl;
+        GLState::deleteTextures(1, &id);
+        return;
+    }
+
+    TextureInfo info;
+    describeTexture(image, info);
+    info.baseLevel = image.baseLevel;
+    info.memoryUsage = uploadLevels(id, image);
+
+    GLState::bindTexture(GL_TEXTURE_2D, id);
+    //glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    //glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    if (image.generateMips)
+    {
+        glGenerateMipmap(GL_TEXTURE_2D);
+        // a full chain adds roughly a third
+        info.memoryUsage += info.memoryUsage / 3;
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, info.baseLevel);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, info.mipCount - 1);
+    GLState::bindTexture(GL_TEXTURE_2D, 0);
+
+    applySampling(id, info.mipCount - info.baseLevel, m_Options.trilinear, m_Options.anisotropy);
+
+    m_RendererID = id;
+    m_Info = info;
+}
+
+bool Texture::streamTo(int baseLevel)
+{
+    if (isLoading() || getID() == 0)
+        return false;
+
+    TextureInfo& current = info();
+    baseLevel = std::min(std::max(baseLevel, 0), current.mipCount - 1);
+    if (baseLevel == current.baseLevel)
+        return true;
+    if (baseLevel > current.baseLevel)
+    {
+        dropLevels(baseLevel);
+        return true;
+    }
+
+    // the file no longer matches what is resident; keep what there is
+    if (m_Request && m_Request->streaming && m_Request->state == TextureRequest::State::Failed)
+        return false;
+
+    if (m_Options.loader)
+    {
+        m_Request = m_Options.loader->requestLevels(m_RendererID, m_FilePath, m_Options, current, baseLevel);
+        return true;
+    }
+
+    TextureOptions options = m_Options;
+    options.skipLevels = baseLevel;
+    TextureImage image;
+    if (!decodeTexture(m_FilePath, options, image, current.baseLevel - baseLevel) || image.mipCount != current.mipCount ||
+        image.baseLevel + (int)image.levels.size() != current.baseLevel)
+    {
+        std::cout << "Failed to stream in levels of texture: " << m_FilePath << std::endl;
+        return false;
+    }
+
+    current.memoryUsage += uploadLevels(m_RendererID, image);
+    current.baseLevel = image.baseLevel;
+    GLState::bindTexture(GL_TEXTURE_2D, m_RendererID);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, current.baseLevel);
+    GLState::bindTexture(GL_TEXTURE_2D, 0);
+    applySampling(m_RendererID, current.mipCount - current.baseLevel, m_Options.trilinear, m_Options.anisotropy);
+    return true;
+}
+
+void Texture::dropLevels(int baseLevel)
+{
+    TextureInfo& current = info();
+    GLState::bindTexture(GL_TEXTURE_2D, m_RendererID);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, baseLevel);
+    for (int level = current.baseLevel; level < baseLevel; level++)
+    {
+        // a zero-sized image releases the level's storage
+        glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        current.memoryUsage -= std::min(current.memoryUsage, current.levelBytes(level));
+    }
+    GLState::bindTexture(GL_TEXTURE_2D, 0);
+
+    current.baseLevel = baseLevel;
+    applySampling(m_RendererID, current.mipCount - current.baseLevel, m_Options.trilinear, m_Options.anisotropy);
+}
+
+void Texture::requestLevel(int level) const
+{
+    if (m_RequestedFrame != s_CurrentFrame || level < m_RequestedLevel)
+        m_RequestedLevel = level;
+    m_RequestedFrame = s_CurrentFrame;
+}
+
+unsigned int Texture::getID() const
+{
+    // a failed stream-in keeps what was there; a failed first load has nothing
+    if (m_Request && m_Request->state == TextureRequest::State::Failed && !m_Request->streaming)
+        return 0;
+    return m_RendererID;
+}
+
+bool Texture::isReady() const
+{
+    if (!m_Request)
+        return m_RendererID != 0;
+    return m_Request->streaming || m_Request->state == TextureRequest::State::Ready;
+}
+
+bool Texture::isLoading() const
+{
+    return m_Request && m_Request->state == TextureRequest::State::Loading;
+}
+
+const TextureInfo& Texture::info() const
+{
+    return m_Request ? m_Request->info : m_Info;
+}
+
+TextureInfo& Texture::info()
+{
+    return m_Request ? m_Request->info : m_Info;
+}
+
+size_t Texture::getMemoryUsage(int baseLevel) const
+{
+    const TextureInfo& current = info();
+    size_t bytes = 0;
+    for (int level = std::max(baseLevel, 0); level < current.mipCount; level++)
+        bytes += current.levelBytes(level);
+    return bytes;
 }
 
 void Texture::bind(unsigned int slot) const
 {
-    glActiveTexture(GL_TEXTURE0 + slot);
-    glBindTexture(GL_TEXTURE_2D, m_RendererID);
-}
\ No newline at end of file
+    m_LastUsedFrame = s_CurrentFrame;
+
+    unsigned int id = getID();
+    if (isLoading())
+        id = m_Request->placeholderID;
+
+    GLState::activeTexture(GL_TEXTURE0 + slot);
+    GLState::bindTexture(GL_TEXTURE_2D, id);
+}
+
+void Texture::setSampling(bool trilinear, float anisotropy)
+{
+    m_Options.trilinear = trilinear;
+    m_Options.anisotropy = anisotropy;
+
+    if (m_Request)
+    {
+        // applied by the loader once the upload finishes
+        m_Request->options.trilinear = trilinear;
+        m_Request->options.anisotropy = anisotropy;
+        if (isLoading())
+            return;
+    }
+    if (getID() != 0)
+        applySampling(getID(), info().mipCount - info().baseLevel, trilinear, anisotropy);
+}
+
+void Texture::applySampling(unsigned int id, int mipCount, bool trilinear, float anisotropy, GLenum target)
+{
+    GLState::bindTexture(target, id);
+    GLint minFilter = GL_LINEAR;
+    if (mipCount > 1)
+        minFilter = trilinear ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR_MIPMAP_NEAREST;
+    glTexParameteri(target, GL_TEXTURE_MIN_FILTER, minFilter);
+    glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    if (GLExt::hasAnisotropicFiltering)
+    {
+        float amount = std::min(std::max(anisotropy, 1.0f), GLExt::maxAnisotropy);
+        glTexParameterf(target, GL_TEXTURE_MAX_ANISOTROPY_EXT, amount);
+    }
+    GLState::bindTexture(target, 0);
+}
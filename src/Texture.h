@@ -2,22 +2,132 @@
 #define TEXTURE_H
 
 #include <glad/glad.h>
+#include <memory>
 #include <string>
+#include "MipGenerator.h"
+#include "TextureContainer.h"
+
+class TextureLoader;
+struct TextureRequest;
+
+enum class MipSource {
+    None,       // level 0 only
+    CPUBox,     // gamma-correct box filter on load
+    CPUKaiser,  // gamma-correct Kaiser-windowed sinc on load
+    GPU         // glGenerateMipmap
+};
+
+struct TextureOptions {
+    MipSource mips = MipSource::CPUKaiser;
+    bool trilinear = true;     // blend between mip levels
+    float anisotropy = 8.0f;   // clamped to what the driver supports
+    // Load "name.bct" from TextureCooker instead of "name.png" when it exists
+    // and the driver supports its format. A .bct path is always loaded as-is.
+    bool preferCompressed = true;
+    // When set, decoding happens on the loader's worker threads and the upload
+    // is spread over frames; the loader's placeholder is bound until it is done
+    TextureLoader* loader = nullptr;
+    // Leave this many of the largest mip levels out of the first load (at
+    // least one level is kept); TextureManager streams them in when needed
+    int skipLevels = 0;
+};
+
+// Levels of a texture in CPU memory, ready for upload
+struct TextureImage {
+    unsigned int internalFormat = GL_RGBA8;
+    bool compressed = false;
+    bool generateMips = false; // MipSource::GPU: only level 0 is present
+    int width = 0, height = 0; // of level 0 of the full chain
+    int mipCount = 0;          // levels in the full chain
+    int baseLevel = 0;         // chain level of levels[0]
+    std::vector<MipLevel> levels;
+};
+
+// True if the driver can sample textures in format (needs loadGLExtensions)
+bool isBlockFormatSupported(BlockFormat format);
+
+// Reads and decodes path (or its cooked .bct sibling), builds the CPU mip
+// chain, drops options.skipLevels levels and keeps at most levelCount of the
+// rest (0 = all). Makes no GL calls, so it is safe to run on any thread.
+bool decodeTexture(const std::string& path, const TextureOptions& options, TextureImage& image, int levelCount = 0);
+
+// What is known about a texture once its data is on the GPU
+struct TextureInfo {
+    int width = 0, height = 0; // of level 0, even when it is not resident
+    int mipCount = 1;          // levels in the full chain
+    int baseLevel = 0;         // first resident level (GL_TEXTURE_BASE_LEVEL)
+    bool compressed = false;
+    size_t unitBytes = 4;      // per texel, or per 4x4 block when compressed
+    size_t memoryUsage = 0;    // bytes of texture memory used by the resident levels
+
+    size_t levelBytes(int level) const;
+};
+
+// Fills in the size, format and chain length of the texture image is part
+// of; baseLevel and memoryUsage are left to the caller
+void describeTexture(const TextureImage& image, TextureInfo& info);
 
 class Texture {
 public:
-    Texture(const std::string& path);
+    Texture(const std::string& path, const TextureOptions& options = TextureOptions());
     ~Texture();
 
+    // Makes baseLevel the largest resident level. Dropping levels takes
+    // effect at once; missing levels are decoded and uploaded (asynchronously
+    // with a loader) while the current ones stay in use, and only then become
+    // the base level. Ignored (returns false) while a load is still in flight.
+    bool streamTo(int baseLevel);
+
+    // Records the largest level a draw needs this frame; the smallest level
+    // requested in a frame wins. TextureManager streams towards it.
+    void requestLevel(int level) const;
+
     void bind(unsigned int slot = 0) const;
 
-    unsigned int getID() const { return m_RendererID; }
+    // Changes filtering without re-uploading
+    void setSampling(bool trilinear, float anisotropy);
+    static void applySampling(unsigned int id, int mipCount, bool trilinear, float anisotropy, GLenum target = GL_TEXTURE_2D);
+
+    // 0 if loading failed; an asynchronous texture has its ID while it streams in
+    unsigned int getID() const;
+    // False until the first load has been uploaded, or when it failed
+    bool isReady() const;
+    // True while a load or stream-in is still decoding or uploading
+    bool isLoading() const;
+    int getWidth() const { return info().width; }
+    int getHeight() const { return info().height; }
+    int getMipCount() const { return info().mipCount; }
+    int getBaseLevel() const { return info().baseLevel; }
+    bool isCompressed() const { return info().compressed; }
+    size_t getMemoryUsage() const { return info().memoryUsage; }
+    // Bytes the texture would use with baseLevel as its largest level
+    size_t getMemoryUsage(int baseLevel) const;
+    const std::string& getPath() const { return m_FilePath; }
+
+    // Smallest level requested in getRequestedFrame(), see requestLevel
+    int getRequestedLevel() const { return m_RequestedLevel; }
+    unsigned int getRequestedFrame() const { return m_RequestedFrame; }
+
+    // Frame counter stamped by bind(), so unused textures can be found
+    unsigned int getLastUsedFrame() const { return m_LastUsedFrame; }
+    static unsigned int getCurrentFrame() { return s_CurrentFrame; }
+    static void nextFrame() { s_CurrentFrame++; }
 
 private:
     unsigned int m_RendererID;
     std::string m_FilePath;
-    unsigned char* m_LocalBuffer;
-    int m_Width, m_Height, m_BPP;
+    TextureInfo m_Info;
+    TextureOptions m_Options;
+    std::shared_ptr<TextureRequest> m_Request;
+    mutable unsigned int m_LastUsedFrame;
+    mutable int m_RequestedLevel;
+    mutable unsigned int m_RequestedFrame;
+    static unsigned int s_CurrentFrame;
+
+    const TextureInfo& info() const;
+    TextureInfo& info();
+    void load();
+    void dropLevels(int baseLevel);
 };
 
 #endif // TEXTURE_H
@@ -0,0 +1,59 @@
+#include "TextureArray.h"
+#include "GLState.h"
+#include "Texture.h"
+#include "TextureContainer.h"
+#include <iostream>
+
+TextureArray::TextureArray(const std::string& path)
+    : m_RendererID(0), m_Width(0), m_Height(0), m_Layers(0), m_MipCount(0), m_MemoryUsage(0)
+{
+    CompressedImage image;
+    if (!readTextureContainer(path, image))
+    {
+        std::cout << "Failed to load texture array: " << path << std::endl;
+        return;
+    }
+    if (!isBlockFormatSupported(image.format))
+    {
+        std::cout << blockFormatName(image.format) << " is not supported by the driver, skipping " << path << std::endl;
+        return;
+    }
+
+    glGenTextures(1, &m_RendererID);
+    GLState::bindTexture(GL_TEXTURE_2D_ARRAY, m_RendererID);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    for (size_t level = 0; level < image.levels.size(); level++)
+    {
+        const CompressedLevel& data = image.levels[level];
+        glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, (GLint)level, image.glInternalFormat, data.width, data.height,
+            image.layers, 0, (GLsizei)data.data.size(), data.data.data());
+        m_MemoryUsage += data.data.size();
+    }
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, (GLint)image.levels.size() - 1);
+    GLState::bindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    m_Width = image.width;
+    m_Height = image.height;
+    m_Layers = image.layers;
+    m_MipCount = (int)image.levels.size();
+    setSampling(true, 8.0f);
+}
+
+TextureArray::~TextureArray()
+{
+    GLState::deleteTextures(1, &m_RendererID);
+}
+
+void TextureArray::bind(unsigned int slot) const
+{
+    GLState::activeTexture(GL_TEXTURE0 + slot);
+    GLState::bindTexture(GL_TEXTURE_2D_ARRAY, m_RendererID);
+    GLState::activeTexture(GL_TEXTURE0);
+}
+
+void TextureArray::setSampling(bool trilinear, float anisotropy)
+{
+    if (m_RendererID != 0)
+        Texture::applySampling(m_RendererID, m_MipCount, trilinear, anisotropy, GL_TEXTURE_2D_ARRAY);
+}
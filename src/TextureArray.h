@@ -0,0 +1,36 @@
+#ifndef TEXTURE_ARRAY_H
+#define TEXTURE_ARRAY_H
+
+#include <glad/glad.h>
+#include <string>
+
+// A GL_TEXTURE_2D_ARRAY loaded from a layered .bct written by
+// "TextureCooker --pack". Every layer shares size, format and mip count, so
+// any number of materials can be sampled from one binding.
+class TextureArray {
+public:
+    TextureArray(const std::string& path);
+    ~TextureArray();
+
+    TextureArray(const TextureArray&) = delete;
+    TextureArray& operator=(const TextureArray&) = delete;
+
+    void bind(unsigned int slot) const;
+    void setSampling(bool trilinear, float anisotropy);
+
+    // 0 if the file could not be loaded or its format is unsupported
+    unsigned int getID() const { return m_RendererID; }
+    int getWidth() const { return m_Width; }
+    int getHeight() const { return m_Height; }
+    int getLayerCount() const { return m_Layers; }
+    int getMipCount() const { return m_MipCount; }
+    size_t getMemoryUsage() const { return m_MemoryUsage; }
+
+private:
+    unsigned int m_RendererID;
+    int m_Width, m_Height, m_Layers;
+    int m_MipCount;
+    size_t m_MemoryUsage;
+};
+
+#endif // TEXTURE_ARRAY_H
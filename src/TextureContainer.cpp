@@ -0,0 +1,117 @@
+#include "TextureContainer.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace {
+    const uint8_t CONTAINER_IDENTIFIER[12] = { 0xAB, 'B', 'C', 'T', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+    // position of the minor version digit; version 10 has no layerCount
+    const int VERSION_MINOR_OFFSET = 6;
+
+    struct ContainerHeader {
+        uint8_t identifier[12];
+        uint32_t glInternalFormat;
+        uint32_t blockFormat;
+        uint32_t width;
+        uint32_t height;
+        uint32_t levelCount;
+        uint32_t layerCount;
+    };
+
+    struct LevelIndex {
+        uint64_t offset;
+        uint64_t length;
+    };
+
+    uint64_t alignTo8(uint64_t value)
+    {
+        return (value + 7) & ~7ull;
+    }
+}
+
+bool writeTextureContainer(const std::string& path, const CompressedImage& image)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+        return false;
+
+    ContainerHeader header;
+    memcpy(header.identifier, CONTAINER_IDENTIFIER, sizeof(header.identifier));
+    header.glInternalFormat = image.glInternalFormat;
+    header.blockFormat = (uint32_t)image.format;
+    header.width = (uint32_t)image.width;
+    header.height = (uint32_t)image.height;
+    header.levelCount = (uint32_t)image.levels.size();
+    header.layerCount = (uint32_t)image.layers;
+
+    std::vector<LevelIndex> index(image.levels.size());
+    uint64_t offset = alignTo8(sizeof(header) + sizeof(LevelIndex) * index.size());
+    for (size_t level = 0; level < image.levels.size(); level++)
+    {
+        index[level].offset = offset;
+        index[level].length = image.levels[level].data.size();
+        offset = alignTo8(offset + index[level].length);
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(index.data()), sizeof(LevelIndex) * index.size());
+    for (size_t level = 0; level < image.levels.size(); level++)
+    {
+        static const char padding[8] = {};
+        uint64_t position = (uint64_t)file.tellp();
+        file.write(padding, (std::streamsize)(index[level].offset - position));
+        file.write(reinterpret_cast<const char*>(image.levels[level].data.data()), (std::streamsize)index[level].length);
+    }
+    return (bool)file;
+}
+
+bool readTextureContainer(const std::string& path, CompressedImage& image)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+
+    ContainerHeader header;
+    const size_t version10Size = sizeof(header) - sizeof(header.layerCount);
+    if (!file.read(reinterpret_cast<char*>(&header), version10Size))
+        return false;
+
+    uint8_t version10[12];
+    memcpy(version10, CONTAINER_IDENTIFIER, sizeof(version10));
+    version10[VERSION_MINOR_OFFSET] = '0';
+    if (memcmp(header.identifier, version10, sizeof(version10)) == 0)
+        header.layerCount = 1;
+    else if (memcmp(header.identifier, CONTAINER_IDENTIFIER, sizeof(header.identifier)) != 0 ||
+        !file.read(reinterpret_cast<char*>(&header.layerCount), sizeof(header.layerCount)))
+        return false;
+
+    if (header.blockFormat > (uint32_t)BlockFormat::BC7 || header.levelCount == 0 || header.levelCount > 32 ||
+        header.layerCount == 0 || header.layerCount > 2048)
+        return false;
+
+    std::vector<LevelIndex> index(header.levelCount);
+    if (!file.read(reinterpret_cast<char*>(index.data()), sizeof(LevelIndex) * index.size()))
+        return false;
+
+    image.format = (BlockFormat)header.blockFormat;
+    image.glInternalFormat = header.glInternalFormat;
+    image.width = (int)header.width;
+    image.height = (int)header.height;
+    image.layers = (int)header.layerCount;
+    image.levels.resize(header.levelCount);
+
+    for (uint32_t level = 0; level < header.levelCount; level++)
+    {
+        CompressedLevel& out = image.levels[level];
+        out.width = std::max(1, image.width >> level);
+        out.height = std::max(1, image.height >> level);
+        if (index[level].length != compressedSize(out.width, out.height, image.format) * image.layers)
+            return false;
+
+        out.data.resize((size_t)index[level].length);
+        file.seekg((std::streamoff)index[level].offset);
+        if (!file.read(reinterpret_cast<char*>(out.data.data()), (std::streamsize)out.data.size()))
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,38 @@
+#ifndef TEXTURE_CONTAINER_H
+#define TEXTURE_CONTAINER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "TextureEncoder.h"
+
+// Block-compressed image with its full mip chain, as written by the
+// TextureCooker tool and uploaded as-is by Texture (or TextureArray when it
+// has several layers).
+//
+// File layout (".bct", little endian), modelled on KTX2 but without its
+// DFD/supercompression sections:
+//   12-byte identifier "\xABBCT 11\xBB\r\n\x1A\n"
+//   uint32 glInternalFormat, blockFormat, width, height, levelCount, layerCount
+//   levelCount x { uint64 offset, uint64 length }   (level 0 first)
+//   level data, each level starting on an 8-byte boundary and holding every
+//   layer of that level one after another
+// Version 10 files have no layerCount and a single layer.
+struct CompressedLevel {
+    int width, height;
+    std::vector<uint8_t> data; // all layers
+};
+
+struct CompressedImage {
+    BlockFormat format = BlockFormat::BC1;
+    unsigned int glInternalFormat = 0;
+    int width = 0, height = 0;
+    int layers = 1;
+    std::vector<CompressedLevel> levels;
+};
+
+bool writeTextureContainer(const std::string& path, const CompressedImage& image);
+// Fails on a bad identifier, unknown format or truncated file
+bool readTextureContainer(const std::string& path, CompressedImage& image);
+
+#endif // TEXTURE_CONTAINER_H
@@ -0,0 +1,731 @@
+#include "TextureEncoder.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define TEXTURE_ENCODER_SSE 1
+#include <xmmintrin.h>
+#endif
+
+namespace {
+    // GL enums, kept local so the encoder (also built into TextureCooker) needs no GL header
+    const unsigned int FORMAT_RGBA_S3TC_DXT1 = 0x83F1;
+    const unsigned int FORMAT_RGBA_S3TC_DXT5 = 0x83F3;
+    const unsigned int FORMAT_RG_RGTC2 = 0x8DBD;
+    const unsigned int FORMAT_RGBA_BPTC_UNORM = 0x8E8C;
+
+    // 16 texels of a block, RGBA as floats in 0..255
+    struct Block {
+        alignas(16) float texels[16][4];
+    };
+
+    void loadBlock(const uint8_t* rgba, int width, int height, int bx, int by, Block& block)
+    {
+        for (int y = 0; y < 4; y++)
+        {
+            int sy = std::min(by * 4 + y, height - 1);
+            for (int x = 0; x < 4; x++)
+            {
+                int sx = std::min(bx * 4 + x, width - 1);
+                const uint8_t* src = rgba + ((size_t)sy * width + sx) * 4;
+                for (int c = 0; c < 4; c++)
+                    block.texels[y * 4 + x][c] = src[c];
+            }
+        }
+    }
+
+    // Picks the closest palette entry for every texel (squared error over the
+    // channels enabled in mask) and returns the total error
+    float selectIndices(const Block& block, const float palette[][4], int paletteSize, const float mask[4], uint8_t indices[16])
+    {
+        float total = 0.0f;
+#ifdef TEXTURE_ENCODER_SSE
+        __m128 channelMask = _mm_loadu_ps(mask);
+        __m128 entries[16];
+        for (int p = 0; p < paletteSize; p++)
+            entries[p] = _mm_mul_ps(_mm_loadu_ps(palette[p]), channelMask);
+
+        for (int i = 0; i < 16; i++)
+        {
+            __m128 texel = _mm_mul_ps(_mm_load_ps(block.texels[i]), channelMask);
+            float best = 1e30f;
+            int bestIndex = 0;
+            for (int p = 0; p < paletteSize; p++)
+            {
+                __m128 diff = _mm_sub_ps(texel, entries[p]);
+                __m128 sq = _mm_mul_ps(diff, diff);
+                // horizontal add of the four channels
+                __m128 shuf = _mm_shuffle_ps(sq, sq, _MM_SHUFFLE(2, 3, 0, 1));
+                __m128 sums = _mm_add_ps(sq, shuf);
+                shuf = _mm_movehl_ps(shuf, sums);
+                float error = _mm_cvtss_f32(_mm_add_ss(sums, shuf));
+                if (error < best)
+                {
+                    best = error;
+                    bestIndex = p;
+                }
+            }
+            indices[i] = (uint8_t)bestIndex;
+            total += best;
+        }
+#else
+        for (int i = 0; i < 16; i++)
+        {
+            float best = 1e30f;
+            int bestIndex = 0;
+            for (int p = 0; p < paletteSize; p++)
+            {
+                float error = 0.0f;
+                for (int c = 0; c < 4; c++)
+                {
+                    float d = (block.texels[i][c] - palette[p][c]) * mask[c];
+                    error += d * d;
+                }
+                if (error < best)
+                {
+                    best = error;
+                    bestIndex = p;
+                }
+            }
+            indices[i] = (uint8_t)bestIndex;
+            total += best;
+        }
+#endif
+        return total;
+    }
+
+    // Mean and principal axis of the block over `channels` channels
+    void principalAxis(const Block& block, int channels, float mean[4], float axis[4])
+    {
+        for (int c = 0; c < 4; c++)
+        {
+            mean[c] = 0.0f;
+            axis[c] = 0.0f;
+        }
+        for (int i = 0; i < 16; i++)
+            for (int c = 0; c < channels; c++)
+                mean[c] += block.texels[i][c] / 16.0f;
+
+        float cov[4][4] = {};
+        for (int i = 0; i < 16; i++)
+        {
+            float d[4];
+            for (int c = 0; c < channels; c++)
+                d[c] = block.texels[i][c] - mean[c];
+            for (int a = 0; a < channels; a++)
+                for (int b = 0; b < channels; b++)
+                    cov[a][b] += d[a] * d[b];
+        }
+
+        // power iteration
+        for (int c = 0; c < channels; c++)
+            axis[c] = 1.0f;
+        for (int iteration = 0; iteration < 8; iteration++)
+        {
+            float next[4] = {};
+            for (int a = 0; a < channels; a++)
+                for (int b = 0; b < channels; b++)
+                    next[a] += cov[a][b] * axis[b];
+            float length = 0.0f;
+            for (int c = 0; c < channels; c++)
+                length += next[c] * next[c];
+            length = sqrtf(length);
+            if (length < 1e-6f)
+                break;
+            for (int c = 0; c < channels; c++)
+                axis[c] = next[c] / length;
+        }
+    }
+
+    // Endpoints at the extents of the texels projected on the principal axis
+    void axisEndpoints(const Block& block, int channels, float e0[4], float e1[4])
+    {
+        float mean[4], axis[4];
+        principalAxis(block, channels, mean, axis);
+        float minT = 1e30f, maxT = -1e30f;
+        for (int i = 0; i < 16; i++)
+        {
+            float t = 0.0f;
+            for (int c = 0; c < channels; c++)
+                t += (block.texels[i][c] - mean[c]) * axis[c];
+            minT = std::min(minT, t);
+            maxT = std::max(maxT, t);
+        }
+        for (int c = 0; c < 4; c++)
+        {
+            e0[c] = c < channels ? std::min(255.0f, std::max(0.0f, mean[c] + axis[c] * maxT)) : 255.0f;
+            e1[c] = c < channels ? std::min(255.0f, std::max(0.0f, mean[c] + axis[c] * minT)) : 255.0f;
+        }
+    }
+
+    // Least-squares endpoints for fixed indices, where texel i is
+    // e0 * (1 - w[i]) + e1 * w[i]. Returns false if the system is singular.
+    bool refineEndpoints(const Block& block, const float weights[16], int channels, float e0[4], float e1[4])
+    {
+        float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+        float ax[4] = {}, bx[4] = {};
+        for (int i = 0; i < 16; i++)
+        {
+            float b = weights[i], a = 1.0f - b;
+            aa += a * a;
+            ab += a * b;
+            bb += b * b;
+            for (int c = 0; c < channels; c++)
+            {
+                ax[c] += a * block.texels[i][c];
+                bx[c] += b * block.texels[i][c];
+            }
+        }
+        float det = aa * bb - ab * ab;
+        if (fabsf(det) < 1e-6f)
+            return false;
+        for (int c = 0; c < channels; c++)
+        {
+            e0[c] = std::min(255.0f, std::max(0.0f, (ax[c] * bb - bx[c] * ab) / det));
+            e1[c] = std::min(255.0f, std::max(0.0f, (bx[c] * aa - ax[c] * ab) / det));
+        }
+        return true;
+    }
+
+    // ---- BC1 -------------------------------------------------------------
+
+    uint16_t packRGB565(const float color[4])
+    {
+        int r = (int)(color[0] * 31.0f / 255.0f + 0.5f);
+        int g = (int)(color[1] * 63.0f / 255.0f + 0.5f);
+        int b = (int)(color[2] * 31.0f / 255.0f + 0.5f);
+        return (uint16_t)((std::min(r, 31) << 11) | (std::min(g, 63) << 5) | std::min(b, 31));
+    }
+
+    void unpackRGB565(uint16_t packed, float color[4])
+    {
+        int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+        color[0] = (float)((r << 3) | (r >> 2));
+        color[1] = (float)((g << 2) | (g >> 4));
+        color[2] = (float)((b << 3) | (b >> 2));
+        color[3] = 255.0f;
+    }
+
+    void bc1Palette(uint16_t c0, uint16_t c1, float palette[4][4])
+    {
+        unpackRGB565(c0, palette[0]);
+        unpackRGB565(c1, palette[1]);
+        for (int c = 0; c < 3; c++)
+        {
+            if (c0 > c1)
+            {
+                palette[2][c] = floorf((2.0f * palette[0][c] + palette[1][c]) / 3.0f);
+                palette[3][c] = floorf((palette[0][c] + 2.0f * palette[1][c]) / 3.0f);
+            }
+            else
+            {
+                palette[2][c] = floorf((palette[0][c] + palette[1][c]) / 2.0f);
+                palette[3][c] = 0.0f;
+            }
+        }
+        palette[2][3] = 255.0f;
+        palette[3][3] = c0 > c1 ? 255.0f : 0.0f;
+    }
+
+    // Always uses the opaque four-colour mode (c0 > c1)
+    void encodeBC1(const Block& block, EncodePreset preset, uint8_t* out)
+    {
+        static const float rgbMask[4] = { 1.0f, 1.0f, 1.0f, 0.0f };
+        // weight of endpoint 1 for each four-colour index
+        static const float indexWeights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+        float e0[4], e1[4];
+        axisEndpoints(block, 3, e0, e1);
+
+        uint16_t bestC0 = 0, bestC1 = 0;
+        uint8_t bestIndices[16] = {};
+        float bestError = 1e30f;
+        int iterations = preset == EncodePreset::Quality ? 3 : 1;
+        for (int iteration = 0; iteration < iterations; iteration++)
+        {
+            uint16_t c0 = packRGB565(e0), c1 = packRGB565(e1);
+            if (c0 < c1)
+                std::swap(c0, c1);
+
+            uint8_t indices[16];
+            float palette[4][4];
+            float error;
+            if (c0 == c1)
+            {
+                // flat block; every texel uses c0
+                bc1Palette(c0, c1, palette);
+                memset(indices, 0, sizeof(indices));
+                error = 0.0f;
+                for (int i = 0; i < 16; i++)
+                    for (int c = 0; c < 3; c++)
+                        error += (block.texels[i][c] - palette[0][c]) * (block.texels[i][c] - palette[0][c]);
+            }
+            else
+            {
+                bc1Palette(c0, c1, palette);
+                error = selectIndices(block, palette, 4, rgbMask, indices);
+            }
+
+            if (error < bestError)
+            {
+                bestError = error;
+                bestC0 = c0;
+                bestC1 = c1;
+                memcpy(bestIndices, indices, sizeof(indices));
+            }
+
+            float weights[16];
+            for (int i = 0; i < 16; i++)
+                weights[i] = indexWeights[bestIndices[i]];
+            unpackRGB565(bestC0, e0);
+            unpackRGB565(bestC1, e1);
+            if (!refineEndpoints(block, weights, 3, e0, e1))
+                break;
+        }
+
+        uint32_t bits = 0;
+        for (int i = 0; i < 16; i++)
+            bits |= (uint32_t)bestIndices[i] << (2 * i);
+        out[0] = bestC0 & 0xFF;
+        out[1] = bestC0 >> 8;
+        out[2] = bestC1 & 0xFF;
+        out[3] = bestC1 >> 8;
+        for (int i = 0; i < 4; i++)
+            out[4 + i] = (bits >> (8 * i)) & 0xFF;
+    }
+
+    void decodeBC1(const uint8_t* in, uint8_t texels[16][4])
+    {
+        uint16_t c0 = in[0] | (in[1] << 8), c1 = in[2] | (in[3] << 8);
+        float palette[4][4];
+        bc1Palette(c0, c1, palette);
+        uint32_t bits = in[4] | (in[5] << 8) | (in[6] << 16) | ((uint32_t)in[7] << 24);
+        for (int i = 0; i < 16; i++)
+        {
+            int index = (bits >> (2 * i)) & 3;
+            for (int c = 0; c < 4; c++)
+                texels[i][c] = (uint8_t)palette[index][c];
+        }
+    }
+
+    // ---- BC4 (one channel; used for BC3 alpha and both BC5 channels) ------
+
+    void bc4Palette(int a0, int a1, float palette[8])
+    {
+        palette[0] = (float)a0;
+        palette[1] = (float)a1;
+        for (int i = 1; i < 7; i++)
+            palette[1 + i] = floorf(((7 - i) * a0 + i * a1) / 7.0f + 0.5f);
+    }
+
+    float bc4Indices(const float values[16], const float palette[8], uint8_t indices[16])
+    {
+        float total = 0.0f;
+        for (int i = 0; i < 16; i++)
+        {
+            float best = 1e30f;
+            for (int p = 0; p < 8; p++)
+            {
+                float d = values[i] - palette[p];
+                if (d * d < best)
+                {
+                    best = d * d;
+                    indices[i] = (uint8_t)p;
+                }
+            }
+            total += best;
+        }
+        return total;
+    }
+
+    void encodeBC4(const Block& block, int channel, EncodePreset preset, uint8_t* out)
+    {
+        float values[16];
+        int minValue = 255, maxValue = 0;
+        for (int i = 0; i < 16; i++)
+        {
+            values[i] = block.texels[i][channel];
+            minValue = std::min(minValue, (int)values[i]);
+            maxValue = std::max(maxValue, (int)values[i]);
+        }
+
+        int bestA0 = maxValue, bestA1 = minValue;
+        uint8_t bestIndices[16] = {};
+        if (maxValue > minValue)
+        {
+            // the quality preset also tries slightly inset endpoints
+            int range = preset == EncodePreset::Quality ? 2 : 0;
+            float bestError = 1e30f;
+            for (int d0 = 0; d0 <= range; d0++)
+            {
+                for (int d1 = 0; d1 <= range; d1++)
+                {
+                    int a0 = maxValue - d0, a1 = minValue + d1;
+                    if (a0 <= a1)
+                        continue;
+                    float palette[8];
+                    uint8_t indices[16];
+                    bc4Palette(a0, a1, palette);
+                    float error = bc4Indices(values, palette, indices);
+                    if (error < bestError)
+                    {
+                        bestError = error;
+                        bestA0 = a0;
+                        bestA1 = a1;
+                        memcpy(bestIndices, indices, sizeof(indices));
+                    }
+                }
+            }
+        }
+
+        out[0] = (uint8_t)bestA0;
+        out[1] = (uint8_t)bestA1;
+        uint64_t bits = 0;
+        for (int i = 0; i < 16; i++)
+            bits |= (uint64_t)bestIndices[i] << (3 * i);
+        for (int i = 0; i < 6; i++)
+            out[2 + i] = (bits >> (8 * i)) & 0xFF;
+    }
+
+    void decodeBC4(const uint8_t* in, uint8_t texels[16][4], int channel)
+    {
+        int a0 = in[0], a1 = in[1];
+        float palette[8];
+        if (a0 > a1)
+        {
+            bc4Palette(a0, a1, palette);
+        }
+        else
+        {
+            palette[0] = (float)a0;
+            palette[1] = (float)a1;
+            for (int i = 1; i < 5; i++)
+                palette[1 + i] = floorf(((5 - i) * a0 + i * a1) / 5.0f + 0.5f);
+            palette[6] = 0.0f;
+            palette[7] = 255.0f;
+        }
+        uint64_t bits = 0;
+        for (int i = 0; i < 6; i++)
+            bits |= (uint64_t)in[2 + i] << (8 * i);
+        for (int i = 0; i < 16; i++)
+            texels[i][channel] = (uint8_t)palette[(bits >> (3 * i)) & 7];
+    }
+
+    // ---- BC7 mode 6 (one subset, RGBA 7.7.7.7 endpoints + p-bit, 4-bit indices)
+
+    const int BC7_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    struct BitWriter {
+        uint8_t* out;
+        int position;
+        void put(uint32_t value, int bits)
+        {
+            for (int i = 0; i < bits; i++, position++)
+            {
+                if (value & (1u << i))
+                    out[position >> 3] |= (uint8_t)(1u << (position & 7));
+            }
+        }
+    };
+
+    uint32_t readBits(const uint8_t* in, int& position, int bits)
+    {
+        uint32_t value = 0;
+        for (int i = 0; i < bits; i++, position++)
+            value |= (uint32_t)((in[position >> 3] >> (position & 7)) & 1) << i;
+        return value;
+    }
+
+    void bc7Palette(const int e0[4], const int e1[4], float palette[16][4])
+    {
+        for (int i = 0; i < 16; i++)
+            for (int c = 0; c < 4; c++)
+                palette[i][c] = (float)(((64 - BC7_WEIGHTS[i]) * e0[c] + BC7_WEIGHTS[i] * e1[c] + 32) >> 6);
+    }
+
+    // 7-bit endpoint plus shared p-bit -> 8-bit value
+    void quantizeBC7(const float endpoint[4], int pbit, int quantized[4], int expanded[4])
+    {
+        for (int c = 0; c < 4; c++)
+        {
+            int q = (int)floorf((endpoint[c] - pbit) / 2.0f + 0.5f);
+            quantized[c] = std::min(127, std::max(0, q));
+            expanded[c] = (quantized[c] << 1) | pbit;
+        }
+    }
+
+    void encodeBC7(const Block& block, EncodePreset preset, uint8_t* out)
+    {
+        static const float rgbaMask[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+        float e0[4], e1[4];
+        axisEndpoints(block, 4, e0, e1);
+
+        int bestQ0[4] = {}, bestQ1[4] = {}, bestP0 = 0, bestP1 = 0;
+        uint8_t bestIndices[16] = {};
+        float bestError = 1e30f;
+
+        int iterations = preset == EncodePreset::Quality ? 3 : 1;
+        for (int iteration = 0; iteration < iterations; iteration++)
+        {
+            // fast tries matching p-bits only, quality tries all four combinations
+            int pbitTries = preset == EncodePreset::Quality ? 4 : 2;
+            for (int p = 0; p < pbitTries; p++)
+            {
+                int p0 = p & 1, p1 = preset == EncodePreset::Quality ? (p >> 1) : (p & 1);
+                int q0[4], q1[4], x0[4], x1[4];
+                quantizeBC7(e0, p0, q0, x0);
+                quantizeBC7(e1, p1, q1, x1);
+
+                float palette[16][4];
+                uint8_t indices[16];
+                bc7Palette(x0, x1, palette);
+                float error = selectIndices(block, palette, 16, rgbaMask, indices);
+                if (error < bestError)
+                {
+                    bestError = error;
+                    memcpy(bestQ0, q0, sizeof(q0));
+                    memcpy(bestQ1, q1, sizeof(q1));
+                    bestP0 = p0;
+                    bestP1 = p1;
+                    memcpy(bestIndices, indices, sizeof(indices));
+                }
+            }
+
+            if (iteration + 1 < iterations)
+            {
+                float weights[16];
+                for (int i = 0; i < 16; i++)
+                    weights[i] = BC7_WEIGHTS[bestIndices[i]] / 64.0f;
+                if (!refineEndpoints(block, weights, 4, e0, e1))
+                    break;
+            }
+        }
+
+        // the anchor (texel 0) index is stored with an implied zero top bit
+        if (bestIndices[0] & 8)
+        {
+            std::swap(bestQ0, bestQ1);
+            std::swap(bestP0, bestP1);
+            for (int i = 0; i < 16; i++)
+                bestIndices[i] = 15 - bestIndices[i];
+        }
+
+        memset(out, 0, 16);
+        BitWriter writer = { out, 0 };
+        writer.put(1u << 6, 7); // mode 6
+        for (int c = 0; c < 4; c++)
+        {
+            writer.put(bestQ0[c], 7);
+            writer.put(bestQ1[c], 7);
+        }
+        writer.put(bestP0, 1);
+        writer.put(bestP1, 1);
+        writer.put(bestIndices[0], 3);
+        for (int i = 1; i < 16; i++)
+            writer.put(bestIndices[i], 4);
+    }
+
+    void decodeBC7(const uint8_t* in, uint8_t texels[16][4])
+    {
+        int position = 0;
+        if (readBits(in, position, 7) != (1u << 6))
+        {
+            // not mode 6; never produced by encodeBC7
+            for (int i = 0; i < 16; i++)
+            {
+                texels[i][0] = 255; texels[i][1] = 0; texels[i][2] = 255; texels[i][3] = 255;
+            }
+            return;
+        }
+
+        int q0[4], q1[4];
+        for (int c = 0; c < 4; c++)
+        {
+            q0[c] = (int)readBits(in, position, 7);
+            q1[c] = (int)readBits(in, position, 7);
+        }
+        int p0 = (int)readBits(in, position, 1), p1 = (int)readBits(in, position, 1);
+        int x0[4], x1[4];
+        for (int c = 0; c < 4; c++)
+        {
+            x0[c] = (q0[c] << 1) | p0;
+            x1[c] = (q1[c] << 1) | p1;
+        }
+        float palette[16][4];
+        bc7Palette(x0, x1, palette);
+        for (int i = 0; i < 16; i++)
+        {
+            int index = (int)readBits(in, position, i == 0 ? 3 : 4);
+            for (int c = 0; c < 4; c++)
+                texels[i][c] = (uint8_t)palette[index][c];
+        }
+    }
+
+    void encodeBlock(const Block& block, BlockFormat format, EncodePreset preset, uint8_t* out)
+    {
+        switch (format)
+        {
+        case BlockFormat::BC1:
+            encodeBC1(block, preset, out);
+            break;
+        case BlockFormat::BC3:
+            encodeBC4(block, 3, preset, out);
+            encodeBC1(block, preset, out + 8);
+            break;
+        case BlockFormat::BC5:
+            encodeBC4(block, 0, preset, out);
+            encodeBC4(block, 1, preset, out + 8);
+            break;
+        case BlockFormat::BC7:
+            encodeBC7(block, preset, out);
+            break;
+        }
+    }
+}
+
+size_t blockBytes(BlockFormat format)
+{
+    return format == BlockFormat::BC1 ? 8 : 16;
+}
+
+size_t compressedSize(int width, int height, BlockFormat format)
+{
+    return (size_t)((width + 3) / 4) * ((height + 3) / 4) * blockBytes(format);
+}
+
+unsigned int glInternalFormat(BlockFormat format)
+{
+    switch (format)
+    {
+    case BlockFormat::BC1: return FORMAT_RGBA_S3TC_DXT1;
+    case BlockFormat::BC3: return FORMAT_RGBA_S3TC_DXT5;
+    case BlockFormat::BC5: return FORMAT_RG_RGTC2;
+    case BlockFormat::BC7: return FORMAT_RGBA_BPTC_UNORM;
+    }
+    return 0;
+}
+
+const char* blockFormatName(BlockFormat format)
+{
+    switch (format)
+    {
+    case BlockFormat::BC1: return "BC1";
+    case BlockFormat::BC3: return "BC3";
+    case BlockFormat::BC5: return "BC5";
+    case BlockFormat::BC7: return "BC7";
+    }
+    return "?";
+}
+
+bool parseBlockFormat(const std::string& name, BlockFormat& format)
+{
+    std::string lower = name;
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return (char)tolower(c); });
+    if (lower == "bc1") format = BlockFormat::BC1;
+    else if (lower == "bc3") format = BlockFormat::BC3;
+    else if (lower == "bc5") format = BlockFormat::BC5;
+    else if (lower == "bc7") format = BlockFormat::BC7;
+    else return false;
+    return true;
+}
+
+std::vector<uint8_t> encodeBlocks(const uint8_t* rgba, int width, int height, BlockFormat format, EncodePreset preset, int threads)
+{
+    int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+    size_t bytesPerBlock = blockBytes(format);
+    std::vector<uint8_t> output((size_t)blocksX * blocksY * bytesPerBlock);
+
+    if (threads <= 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = std::min(threads, blocksY);
+
+    // rows of blocks are interleaved across workers so uneven content balances out
+    auto worker = [&](int first) {
+        Block block;
+        for (int by = first; by < blocksY; by += threads)
+        {
+            for (int bx = 0; bx < blocksX; bx++)
+            {
+                loadBlock(rgba, width, height, bx, by, block);
+                encodeBlock(block, format, preset, &output[((size_t)by * blocksX + bx) * bytesPerBlock]);
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; t++)
+        pool.emplace_back(worker, t);
+    worker(0);
+    for (std::thread& thread : pool)
+        thread.join();
+    return output;
+}
+
+std::vector<uint8_t> decodeBlocks(const uint8_t* blocks, int width, int height, BlockFormat format)
+{
+    int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+    size_t bytesPerBlock = blockBytes(format);
+    std::vector<uint8_t> rgba((size_t)width * height * 4);
+
+    for (int by = 0; by < blocksY; by++)
+    {
+        for (int bx = 0; bx < blocksX; bx++)
+        {
+            const uint8_t* in = blocks + ((size_t)by * blocksX + bx) * bytesPerBlock;
+            uint8_t texels[16][4] = {};
+            switch (format)
+            {
+            case BlockFormat::BC1:
+                decodeBC1(in, texels);
+                break;
+            case BlockFormat::BC3:
+                decodeBC1(in + 8, texels);
+                decodeBC4(in, texels, 3);
+                break;
+            case BlockFormat::BC5:
+                decodeBC4(in, texels, 0);
+                decodeBC4(in + 8, texels, 1);
+                for (int i = 0; i < 16; i++)
+                    texels[i][3] = 255;
+                break;
+            case BlockFormat::BC7:
+                decodeBC7(in, texels);
+                break;
+            }
+
+            for (int y = 0; y < 4 && by * 4 + y < height; y++)
+                for (int x = 0; x < 4 && bx * 4 + x < width; x++)
+                    memcpy(&rgba[((size_t)(by * 4 + y) * width + bx * 4 + x) * 4], texels[y * 4 + x], 4);
+        }
+    }
+    return rgba;
+}
+
+double computePSNR(const uint8_t* reference, const uint8_t* decoded, int width, int height, BlockFormat format)
+{
+    // channels the format actually stores
+    int firstChannel = 0, lastChannel = 3;
+    if (format == BlockFormat::BC1)
+        lastChannel = 2;
+    else if (format == BlockFormat::BC5)
+        lastChannel = 1;
+
+    double squaredError = 0.0;
+    size_t samples = 0;
+    for (size_t i = 0; i < (size_t)width * height; i++)
+    {
+        for (int c = firstChannel; c <= lastChannel; c++)
+        {
+            double d = (double)reference[i * 4 + c] - (double)decoded[i * 4 + c];
+            squaredError += d * d;
+            samples++;
+        }
+    }
+    if (squaredError == 0.0)
+        return 99.0;
+    double mse = squaredError / samples;
+    return 10.0 * log10(255.0 * 255.0 / mse);
+}
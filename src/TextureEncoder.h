@@ -0,0 +1,37 @@
+#ifndef TEXTURE_ENCODER_H
+#define TEXTURE_ENCODER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class BlockFormat {
+    BC1,  // RGB, 4 bpp
+    BC3,  // RGBA (BC1 color + BC4 alpha), 8 bpp
+    BC5,  // RG (two BC4 channels), 8 bpp, for normal maps
+    BC7   // RGBA, 8 bpp, best quality
+};
+
+enum class EncodePreset {
+    Fast,     // principal-axis endpoints only
+    Quality   // plus least-squares endpoint refinement and wider searches
+};
+
+// Block-compresses an RGBA8 image (4x4 blocks, edges padded by clamping).
+// Rows of blocks are spread over `threads` worker threads (0 = all cores).
+std::vector<uint8_t> encodeBlocks(const uint8_t* rgba, int width, int height, BlockFormat format, EncodePreset preset, int threads = 0);
+
+// Expands blocks produced by encodeBlocks back to RGBA8. BC7 decoding only
+// covers mode 6, the only mode the encoder writes.
+std::vector<uint8_t> decodeBlocks(const uint8_t* blocks, int width, int height, BlockFormat format);
+
+// Peak signal-to-noise ratio in dB over the channels the format stores
+double computePSNR(const uint8_t* reference, const uint8_t* decoded, int width, int height, BlockFormat format);
+
+size_t blockBytes(BlockFormat format);
+size_t compressedSize(int width, int height, BlockFormat format);
+unsigned int glInternalFormat(BlockFormat format);
+const char* blockFormatName(BlockFormat format);
+bool parseBlockFormat(const std::string& name, BlockFormat& format);
+
+#endif // TEXTURE_ENCODER_H
@@ -0,0 +1,335 @@
+#include "TextureLoader.h"
+#include "GLExtensions.h"
+#include "GLState.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace {
+    // Rows copied as a unit: one texel row, or one row of 4x4 blocks
+    int rowsPerUnit(const TextureImage& image)
+    {
+        return image.compressed ? 4 : 1;
+    }
+
+    size_t alignOffset(size_t offset)
+    {
+        return (offset + 15) & ~(size_t)15;
+    }
+}
+
+TextureLoader::TextureLoader(int threads, size_t uploadBudget)
+    : m_Stop(false), m_Pending(0), m_UploadedLastFrame(0), m_PBO(0), m_Mapped(nullptr),
+    m_UploadBudget(std::max<size_t>(uploadBudget, 256 * 1024)), m_Segment(0), m_Placeholder(0)
+{
+    for (int i = 0; i < STAGING_SEGMENTS; i++)
+        m_Fences[i] = 0;
+
+    // 1x1 mid grey, bound in place of textures that are still streaming in
+    const unsigned char grey[4] = { 128, 128, 128, 255 };
+    glGenTextures(1, &m_Placeholder);
+    GLState::bindTexture(GL_TEXTURE_2D, m_Placeholder);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, grey);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    GLState::bindTexture(GL_TEXTURE_2D, 0);
+
+    // the ring is only written by the CPU, so it goes through the copy-write
+    // target and is bound as GL_PIXEL_UNPACK_BUFFER only while uploading
+    size_t ringSize = m_UploadBudget * STAGING_SEGMENTS;
+    glGenBuffers(1, &m_PBO);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_PBO);
+    if (GLExt::hasBufferStorage)
+    {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        GLExt::BufferStorage(GL_COPY_WRITE_BUFFER, ringSize, NULL, flags);
+        m_Mapped = (unsigned char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, ringSize, flags);
+    }
+    else
+    {
+        glBufferData(GL_COPY_WRITE_BUFFER, ringSize, NULL, GL_STREAM_DRAW);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    if (threads <= 0)
+        threads = std::max(1, (int)std::thread::hardware_concurrency() - 1);
+    for (int i = 0; i < threads; i++)
+        m_Workers.emplace_back(&TextureLoader::workerLoop, this);
+}
+
+TextureLoader::~TextureLoader()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stop = true;
+    }
+    m_Wake.notify_all();
+    for (std::thread& worker : m_Workers)
+        worker.join();
+
+    for (int i = 0; i < STAGING_SEGMENTS; i++)
+    {
+        if (m_Fences[i])
+            glDeleteSync(m_Fences[i]);
+    }
+    // deleting a persistently mapped buffer unmaps it
+    glDeleteBuffers(1, &m_PBO);
+    GLState::deleteTextures(1, &m_Placeholder);
+}
+
+std::shared_ptr<TextureRequest> TextureLoader::request(unsigned int textureID, const std::string& path, const TextureOptions& options)
+{
+    auto job = std::make_shared<Job>();
+    job->request = std::make_shared<TextureRequest>();
+    job->request->textureID = textureID;
+    job->request->placeholderID = m_Placeholder;
+    job->request->options = options;
+    job->path = path;
+    job->options = options;
+    enqueue(job);
+    return job->request;
+}
+
+std::shared_ptr<TextureRequest> TextureLoader::requestLevels(unsigned int textureID, const std::string& path, const TextureOptions& options,
+    const TextureInfo& info, int baseLevel)
+{
+    auto job = std::make_shared<Job>();
+    job->request = std::make_shared<TextureRequest>();
+    job->request->textureID = textureID;
+    job->request->placeholderID = textureID;
+    job->request->streaming = true;
+    job->request->options = options;
+    job->request->info = info;
+    job->path = path;
+    job->options = options;
+    job->options.skipLevels = baseLevel;
+    job->levelCount = info.baseLevel - baseLevel;
+    enqueue(job);
+    return job->request;
+}
+
+void TextureLoader::enqueue(const std::shared_ptr<Job>& job)
+{
+    m_Pending++;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_DecodeQueue.push_back(job);
+    }
+    m_Wake.notify_one();
+}
+
+void TextureLoader::workerLoop()
+{
+    while (true)
+    {
+        std::shared_ptr<Job> job;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Wake.wait(lock, [this] { return m_Stop || !m_DecodeQueue.empty(); });
+            if (m_Stop)
+                return;
+            job = m_DecodeQueue.front();
+            m_DecodeQueue.pop_front();
+        }
+
+        if (!job->request->cancelled)
+            job->decoded = decodeTexture(job->path, job->options, job->image, job->levelCount);
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Decoded.push_back(job);
+    }
+}
+
+void TextureLoader::update()
+{
+    m_UploadedLastFrame = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        while (!m_Decoded.empty())
+        {
+            m_Uploading.push_back(m_Decoded.front());
+            m_Decoded.pop_front();
+        }
+    }
+    if (m_Uploading.empty())
+        return;
+
+    // the segment was last used STAGING_SEGMENTS updates ago
+    m_Segment = (m_Segment + 1) % STAGING_SEGMENTS;
+    if (m_Fences[m_Segment])
+    {
+        glClientWaitSync(m_Fences[m_Segment], GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        glDeleteSync(m_Fences[m_Segment]);
+        m_Fences[m_Segment] = 0;
+    }
+
+    size_t segmentStart = (size_t)m_Segment * m_UploadBudget;
+    unsigned char* segment = nullptr;
+    if (m_Mapped)
+    {
+        segment = m_Mapped + segmentStart;
+    }
+    else
+    {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, m_PBO);
+        segment = (unsigned char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, segmentStart, m_UploadBudget,
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        if (!segment)
+            return;
+    }
+
+    // Copy into the staging segment first; with a non-persistent mapping the
+    // buffer has to be unmapped before GL may read from it
+    std::vector<Chunk> chunks;
+    std::vector<std::shared_ptr<Job>> finished;
+    size_t offset = segmentStart, end = segmentStart + m_UploadBudget;
+    while (!m_Uploading.empty())
+    {
+        std::shared_ptr<Job> job = m_Uploading.front();
+        if (job->request->cancelled)
+        {
+            m_Uploading.pop_front();
+            m_Pending--;
+            continue;
+        }
+        // a stream-in has to continue the chain that is already resident
+        const TextureInfo& info = job->request->info;
+        if (job->decoded && job->request->streaming &&
+            (job->image.mipCount != info.mipCount || job->image.compressed != info.compressed ||
+            job->image.baseLevel + (int)job->image.levels.size() != info.baseLevel))
+            job->decoded = false;
+        if (!job->decoded)
+        {
+            std::cout << "Failed to " << (job->request->streaming ? "stream in levels of " : "load ") << "texture: " << job->path << std::endl;
+            job->request->state = TextureRequest::State::Failed;
+            m_Uploading.pop_front();
+            m_Pending--;
+            continue;
+        }
+
+        if (!job->allocated)
+            allocate(*job);
+        if (!stage(*job, segment, segmentStart, offset, end, chunks))
+            break;
+        finished.push_back(job);
+        m_Uploading.pop_front();
+    }
+
+    if (!m_Mapped)
+    {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, m_PBO);
+        glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_PBO);
+    for (const Chunk& chunk : chunks)
+    {
+        const TextureImage& image = chunk.job->image;
+        const MipLevel& level = image.levels[chunk.level];
+        GLint target = (GLint)(image.baseLevel + chunk.level);
+        GLState::bindTexture(GL_TEXTURE_2D, chunk.job->request->textureID);
+        if (image.compressed)
+            glCompressedTexSubImage2D(GL_TEXTURE_2D, target, 0, chunk.row, level.width, chunk.rows,
+                image.internalFormat, (GLsizei)chunk.bytes, (const void*)chunk.offset);
+        else
+            glTexSubImage2D(GL_TEXTURE_2D, target, 0, chunk.row, level.width, chunk.rows,
+                GL_RGBA, GL_UNSIGNED_BYTE, (const void*)chunk.offset);
+        m_UploadedLastFrame += chunk.bytes;
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    GLState::bindTexture(GL_TEXTURE_2D, 0);
+
+    for (const std::shared_ptr<Job>& job : finished)
+        finish(*job);
+
+    m_Fences[m_Segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void TextureLoader::allocate(Job& job)
+{
+    const TextureImage& image = job.image;
+    TextureInfo& info = job.request->info;
+
+    // levels below the current base level are not sampled, so a texture that
+    // is being streamed into stays complete and in use meanwhile
+    GLState::bindTexture(GL_TEXTURE_2D, job.request->textureID);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    for (size_t level = 0; level < image.levels.size(); level++)
+    {
+        const MipLevel& data = image.levels[level];
+        GLint target = (GLint)(image.baseLevel + level);
+        if (image.compressed)
+            glCompressedTexImage2D(GL_TEXTURE_2D, target, image.internalFormat, data.width, data.height, 0,
+                (GLsizei)data.pixels.size(), NULL);
+        else
+            glTexImage2D(GL_TEXTURE_2D, target, image.internalFormat, data.width, data.height, 0,
+                GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        info.memoryUsage += data.pixels.size();
+    }
+    GLState::bindTexture(GL_TEXTURE_2D, 0);
+
+    if (!job.request->streaming)
+        describeTexture(image, info);
+    job.allocated = true;
+}
+
+bool TextureLoader::stage(Job& job, unsigned char* segment, size_t segmentStart, size_t& offset, size_t end, std::vector<Chunk>& chunks)
+{
+    TextureImage& image = job.image;
+    int unitRows = rowsPerUnit(image);
+
+    while (job.level < image.levels.size())
+    {
+        MipLevel& level = image.levels[job.level];
+        int units = (level.height + unitRows - 1) / unitRows;
+        size_t unitBytes = level.pixels.size() / units;
+        int doneUnits = job.row / unitRows;
+
+        size_t space = offset < end ? end - offset : 0;
+        int count = std::min(units - doneUnits, (int)(space / unitBytes));
+        if (count <= 0)
+            return false;
+
+        size_t bytes = unitBytes * count;
+        memcpy(segment + (offset - segmentStart), level.pixels.data() + unitBytes * doneUnits, bytes);
+        int rows = std::min(count * unitRows, level.height - job.row);
+        chunks.push_back({ &job, job.level, job.row, rows, offset, bytes });
+        offset = alignOffset(offset + bytes);
+
+        job.row += rows;
+        if (job.row >= level.height)
+        {
+            // staged; the CPU copy is no longer needed
+            std::vector<unsigned char>().swap(level.pixels);
+            job.level++;
+            job.row = 0;
+        }
+    }
+    return true;
+}
+
+void TextureLoader::finish(Job& job)
+{
+    TextureRequest& request = *job.request;
+    TextureInfo& info = request.info;
+    GLState::bindTexture(GL_TEXTURE_2D, request.textureID);
+    if (job.image.generateMips)
+    {
+        glGenerateMipmap(GL_TEXTURE_2D);
+        // a full chain adds roughly a third
+        info.memoryUsage += info.memoryUsage / 3;
+    }
+    // the new levels only become visible now that all of them are uploaded
+    info.baseLevel = job.image.baseLevel;
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, info.baseLevel);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, info.mipCount - 1);
+    GLState::bindTexture(GL_TEXTURE_2D, 0);
+
+    Texture::applySampling(request.textureID, info.mipCount - info.baseLevel, request.options.trilinear, request.options.anisotropy);
+    request.state = TextureRequest::State::Ready;
+    m_Pending--;
+}
@@ -0,0 +1,113 @@
+#ifndef TEXTURE_LOADER_H
+#define TEXTURE_LOADER_H
+
+#include <glad/glad.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Texture.h"
+
+// Shared between a Texture and the TextureLoader streaming it in. Everything
+// except `cancelled` is only touched on the GL thread.
+struct TextureRequest {
+    enum class State { Loading, Ready, Failed };
+
+    State state = State::Loading;
+    unsigned int textureID = 0;
+    unsigned int placeholderID = 0;
+    // Adds levels to textureID, which already holds info's levels and stays
+    // in use meanwhile; on failure it simply keeps them
+    bool streaming = false;
+    TextureOptions options; // sampling is applied once the upload finishes
+    TextureInfo info;
+    std::atomic<bool> cancelled{ false };
+};
+
+// Decodes textures on a pool of worker threads and streams the results into
+// GL through a ring of pixel unpack buffers, at most uploadBudget bytes per
+// frame. Each ring segment belongs to one frame and is fenced, so the copy
+// into it never waits on the GPU unless the ring has wrapped. With
+// ARB_buffer_storage the ring stays persistently mapped.
+class TextureLoader {
+public:
+    TextureLoader(int threads = 0, size_t uploadBudget = 4 * 1024 * 1024);
+    ~TextureLoader();
+
+    TextureLoader(const TextureLoader&) = delete;
+    TextureLoader& operator=(const TextureLoader&) = delete;
+
+    // Called by Texture; textureID is the (empty) texture to fill
+    std::shared_ptr<TextureRequest> request(unsigned int textureID, const std::string& path, const TextureOptions& options);
+    // Uploads levels [baseLevel, current base) into a texture described by info
+    std::shared_ptr<TextureRequest> requestLevels(unsigned int textureID, const std::string& path, const TextureOptions& options,
+        const TextureInfo& info, int baseLevel);
+
+    // Uploads decoded data within the budget; call once per frame on the GL thread
+    void update();
+
+    unsigned int getPlaceholder() const { return m_Placeholder; }
+    // Textures requested but not yet ready or failed
+    size_t getPendingCount() const { return m_Pending; }
+    size_t getUploadedLastFrame() const { return m_UploadedLastFrame; }
+    bool isPersistentlyMapped() const { return m_Mapped != nullptr; }
+
+private:
+    static const int STAGING_SEGMENTS = 3;
+
+    struct Job {
+        std::shared_ptr<TextureRequest> request;
+        std::string path;
+        TextureOptions options;
+        int levelCount = 0; // passed to decodeTexture
+        TextureImage image;
+        bool decoded = false;
+
+        // upload progress, GL thread only
+        bool allocated = false;
+        size_t level = 0;
+        int row = 0;
+    };
+
+    // A band of rows of one level, copied into the staging ring at offset
+    struct Chunk {
+        Job* job;
+        size_t level;
+        int row;
+        int rows;
+        size_t offset;
+        size_t bytes;
+    };
+
+    std::vector<std::thread> m_Workers;
+    std::mutex m_Mutex;
+    std::condition_variable m_Wake;
+    std::deque<std::shared_ptr<Job>> m_DecodeQueue;
+    std::deque<std::shared_ptr<Job>> m_Decoded;
+    bool m_Stop;
+
+    // GL thread only
+    std::deque<std::shared_ptr<Job>> m_Uploading;
+    size_t m_Pending;
+    size_t m_UploadedLastFrame;
+
+    unsigned int m_PBO;
+    unsigned char* m_Mapped;
+    size_t m_UploadBudget;
+    int m_Segment;
+    GLsync m_Fences[STAGING_SEGMENTS];
+    unsigned int m_Placeholder;
+
+    void enqueue(const std::shared_ptr<Job>& job);
+    void workerLoop();
+    void allocate(Job& job);
+    // Copies as much of the job as fits before end; true once all levels are staged
+    bool stage(Job& job, unsigned char* segment, size_t segmentStart, size_t& offset, size_t end, std::vector<Chunk>& chunks);
+    void finish(Job& job);
+};
+
+#endif // TEXTURE_LOADER_H
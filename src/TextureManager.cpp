@@ -0,0 +1,158 @@
+#include "TextureManager.h"
+#include <algorithm>
+#include <filesystem>
+
+TextureManager::TextureManager(size_t budgetBytes, const TextureOptions& defaults)
+    : m_Budget(budgetBytes), m_Defaults(defaults)
+{
+}
+
+std::string TextureManager::canonicalPath(const std::string& path)
+{
+    std::error_code ec;
+    std::filesystem::path canonical = std::filesystem::weakly_canonical(path, ec);
+    return ec ? path : canonical.generic_string();
+}
+
+std::shared_ptr<Texture> TextureManager::acquire(const std::string& path)
+{
+    return acquire(path, m_Defaults);
+}
+
+std::shared_ptr<Texture> TextureManager::acquire(const std::string& path, const TextureOptions& options)
+{
+    std::string key = canonicalPath(path);
+    auto it = m_Textures.find(key);
+    if (it != m_Textures.end())
+        return it->second;
+
+    auto texture = std::make_shared<Texture>(path, options);
+    m_Textures.emplace(key, texture);
+    return texture;
+}
+
+size_t TextureManager::getResidentBytes() const
+{
+    size_t total = 0;
+    for (const auto& entry : m_Textures)
+        total += entry.second->getMemoryUsage();
+    return total;
+}
+
+int TextureManager::wantedLevel(const Texture& texture, unsigned int frame)
+{
+    int level = 0;
+    if (frame - texture.getRequestedFrame() < REQUEST_FRAMES)
+        level = texture.getRequestedLevel();
+    else if (frame - texture.getLastUsedFrame() >= IDLE_FRAMES)
+        level = texture.getMipCount() - 1;
+    return std::min(std::max(level, 0), texture.getMipCount() - 1);
+}
+
+void TextureManager::update()
+{
+    Texture::nextFrame();
+    unsigned int frame = Texture::getCurrentFrame();
+
+    struct Plan {
+        std::string key;
+        Texture* texture;
+        int level;
+    };
+    std::vector<Plan> plans;
+    size_t total = 0;
+    for (const auto& entry : m_Textures)
+    {
+        Texture* texture = entry.second.get();
+        // textures still loading keep what they have and are just counted
+        if (!texture->isReady() || texture->isLoading())
+        {
+            total += texture->getMemoryUsage();
+            continue;
+        }
+        int level = wantedLevel(*texture, frame);
+        plans.push_back({ entry.first, texture, level });
+        total += texture->getMemoryUsage(level);
+    }
+    // least recently used first
+    std::sort(plans.begin(), plans.end(), [](const Plan& a, const Plan& b) {
+        return a.texture->getLastUsedFrame() < b.texture->getLastUsedFrame();
+    });
+
+    // nobody holds these any more; they were only kept as a cache
+    for (auto it = plans.begin(); it != plans.end() && total > m_Budget;)
+    {
+        if (m_Textures[it->key].use_count() == 1)
+        {
+            total -= it->texture->getMemoryUsage(it->level);
+            m_Textures.erase(it->key);
+            it = plans.erase(it);
+        }
+        else
+            ++it;
+    }
+
+    // give up the largest wanted level until everything fits
+    bool limited = false;
+    while (total > m_Budget)
+    {
+        Plan* largest = nullptr;
+        size_t largestBytes = 0;
+        for (Plan& plan : plans)
+        {
+            size_t bytes = plan.texture->getMemoryUsage(plan.level);
+            if (plan.level < plan.texture->getMipCount() - 1 && bytes > largestBytes)
+            {
+                largest = &plan;
+                largestBytes = bytes;
+            }
+        }
+        if (!largest)
+            break;
+        largest->level++;
+        total -= largestBytes - largest->texture->getMemoryUsage(largest->level);
+        limited = true;
+    }
+
+    // most recently used first; a level of slack when there is room, so
+    // textures hovering around a mip boundary don't stream back and forth
+    int streams = 0;
+    for (auto it = plans.rbegin(); it != plans.rend(); ++it)
+    {
+        Texture* texture = it->texture;
+        int base = texture->getBaseLevel();
+        if (it->level > base)
+        {
+            int level = it->level;
+            size_t slack = texture->getMemoryUsage(level - 1) - texture->getMemoryUsage(level);
+            if (!limited && total + slack <= m_Budget)
+            {
+                level--;
+                total += slack;
+            }
+            if (level > base)
+                texture->streamTo(level);
+        }
+        else if (it->level < base && streams < MAX_STREAMS_PER_UPDATE)
+        {
+            if (texture->streamTo(it->level))
+                streams++;
+        }
+    }
+}
+
+std::vector<TextureResidency> TextureManager::getResidency() const
+{
+    unsigned int frame = Texture::getCurrentFrame();
+    std::vector<TextureResidency> result;
+    for (const auto& entry : m_Textures)
+    {
+        const Texture& texture = *entry.second;
+        result.push_back({ entry.first, texture.getMemoryUsage(), texture.getMipCount(), texture.getBaseLevel(),
+            wantedLevel(texture, frame), entry.second.use_count() - 1, frame - texture.getLastUsedFrame(), texture.isReady() });
+    }
+    std::sort(result.begin(), result.end(), [](const TextureResidency& a, const TextureResidency& b) {
+        return a.residentBytes > b.residentBytes;
+    });
+    return result;
+}
@@ -0,0 +1,67 @@
+#ifndef TEXTURE_MANAGER_H
+#define TEXTURE_MANAGER_H
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Texture.h"
+
+// Snapshot of one managed texture, for the debug UI
+struct TextureResidency {
+    std::string path;
+    size_t residentBytes;
+    int mipCount;
+    int baseLevel;           // largest resident level
+    int wantedLevel;         // what draws asked for lately, before the budget
+    long users;              // handles held outside the manager
+    unsigned int idleFrames; // frames since it was last bound
+    bool ready;
+};
+
+// Hands out shared Texture handles keyed by canonical path, so a file used by
+// several models is decoded and uploaded once, and streams each texture's mip
+// levels in and out so only the detail that is shown is resident.
+//
+// The level a texture wants is the finest one its draws asked for through
+// Texture::requestLevel (e.g. from the screen-space footprint, see
+// Model::requestTextureLevel) over the last few frames. Textures that are
+// bound without requests want full detail, textures that have not been bound
+// lately only their last level. When the wanted levels exceed the budget,
+// textures nobody holds a handle to are evicted first, then the largest
+// wanted levels are given up one at a time. Levels are dropped at once and
+// streamed in a few textures per frame.
+class TextureManager {
+public:
+    TextureManager(size_t budgetBytes = 256 * 1024 * 1024, const TextureOptions& defaults = TextureOptions());
+
+    // Returns the shared texture for path, loading it with options on first use
+    std::shared_ptr<Texture> acquire(const std::string& path);
+    std::shared_ptr<Texture> acquire(const std::string& path, const TextureOptions& options);
+
+    // Call once per frame, before anything is bound: advances the use clock,
+    // then evicts, demotes or promotes to stay within the budget
+    void update();
+
+    void setBudget(size_t budgetBytes) { m_Budget = budgetBytes; }
+    size_t getBudget() const { return m_Budget; }
+    size_t getResidentBytes() const;
+    std::vector<TextureResidency> getResidency() const;
+
+private:
+    // frames a texture has to go unbound before it may be demoted
+    static const unsigned int IDLE_FRAMES = 120;
+    // frames a level request stays in effect
+    static const unsigned int REQUEST_FRAMES = 30;
+    // stream-ins started per update
+    static const int MAX_STREAMS_PER_UPDATE = 2;
+
+    size_t m_Budget;
+    TextureOptions m_Defaults;
+    std::unordered_map<std::string, std::shared_ptr<Texture>> m_Textures;
+
+    static std::string canonicalPath(const std::string& path);
+    static int wantedLevel(const Texture& texture, unsigned int frame);
+};
+
+#endif // TEXTURE_MANAGER_H
@@ -0,0 +1,76 @@
+#include "TexturePack.h"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+TexturePack::TexturePack(const std::string& manifestPath)
+{
+    std::ifstream file(manifestPath);
+    if (!file)
+        return;
+
+    std::filesystem::path directory = std::filesystem::path(manifestPath).parent_path();
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line))
+    {
+        lineNumber++;
+        std::istringstream record(line);
+        std::string kind;
+        if (!(record >> kind) || kind[0] == '#')
+            continue;
+
+        if (kind == "array")
+        {
+            std::string name;
+            record >> name;
+            m_Arrays.push_back(std::make_unique<TextureArray>((directory / name).string()));
+        }
+        else if (kind == "texture")
+        {
+            std::string source;
+            size_t array = 0;
+            TextureSlot slot;
+            if (!(record >> source >> array >> slot.layer >> slot.uvRect.x >> slot.uvRect.y >> slot.uvRect.z >> slot.uvRect.w) ||
+                array >= m_Arrays.size())
+            {
+                std::cout << manifestPath << "(" << lineNumber << "): invalid texture record" << std::endl;
+                continue;
+            }
+            // textures in arrays that failed to load are simply not found
+            if (m_Arrays[array]->getID() == 0)
+                continue;
+            slot.array = m_Arrays[array].get();
+            m_Slots[normalizePath(source)] = slot;
+        }
+    }
+}
+
+std::string TexturePack::normalizePath(const std::string& path)
+{
+    return std::filesystem::path(path).lexically_normal().generic_string();
+}
+
+bool TexturePack::find(const std::string& texturePath, TextureSlot& slot) const
+{
+    auto it = m_Slots.find(normalizePath(texturePath));
+    if (it == m_Slots.end())
+        return false;
+    slot = it->second;
+    return true;
+}
+
+void TexturePack::setSampling(bool trilinear, float anisotropy)
+{
+    for (auto& array : m_Arrays)
+        array->setSampling(trilinear, anisotropy);
+}
+
+size_t TexturePack::getMemoryUsage() const
+{
+    size_t total = 0;
+    for (const auto& array : m_Arrays)
+        total += array->getMemoryUsage();
+    return total;
+}
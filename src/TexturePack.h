@@ -0,0 +1,49 @@
+#ifndef TEXTURE_PACK_H
+#define TEXTURE_PACK_H
+
+#include <glm/glm.hpp>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "TextureArray.h"
+
+// Texture unit texture arrays are bound to while drawing
+const unsigned int TEXTURE_ARRAY_UNIT = 2;
+
+// Where a packed texture lives: a layer of an array, and for atlased
+// textures the rectangle inside that layer
+struct TextureSlot {
+    const TextureArray* array = nullptr;
+    int layer = 0;
+    glm::vec4 uvRect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f); // offset.xy, scale.zw
+};
+
+// The texture arrays and lookup table produced by "TextureCooker --pack".
+//
+// Manifest format (text, one record per line):
+//   array <file.bct>                               (relative to the manifest)
+//   texture <source path> <array> <layer> <u> <v> <width> <height>
+// Source paths are the ones given to the cooker, i.e. relative to the
+// working directory the application runs in.
+class TexturePack {
+public:
+    // A missing manifest gives an empty pack, so callers fall back to
+    // loading individual textures
+    explicit TexturePack(const std::string& manifestPath);
+
+    bool find(const std::string& texturePath, TextureSlot& slot) const;
+    void setSampling(bool trilinear, float anisotropy);
+
+    size_t getArrayCount() const { return m_Arrays.size(); }
+    size_t getTextureCount() const { return m_Slots.size(); }
+    size_t getMemoryUsage() const;
+
+private:
+    std::vector<std::unique_ptr<TextureArray>> m_Arrays;
+    std::unordered_map<std::string, TextureSlot> m_Slots;
+
+    static std::string normalizePath(const std::string& path);
+};
+
+#endif // TEXTURE_PACK_H
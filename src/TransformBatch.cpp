@@ -0,0 +1,249 @@
+#include "TransformBatch.h"
+#include "GLState.h"
+#include <cmath>
+#include <iostream>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define TRANSFORM_BATCH_SSE 1
+#include <xmmintrin.h>
+#endif
+
+// texels computed from the transform; the rest are copied from the inputs
+const int MATRIX_TEXELS = 11;
+
+TransformBatch::TransformBatch()
+    : m_Buffer(0), m_Texture(0), m_BufferSize(0), m_Capacity(0), m_OverCapacity(false)
+{
+    GLint maxTexels = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+    m_Capacity = (size_t)maxTexels / TRANSFORM_TEXELS;
+    glGenBuffers(1, &m_Buffer);
+    glGenTextures(1, &m_Texture);
+    glBindBuffer(GL_TEXTURE_BUFFER, m_Buffer);
+    GLState::bindTexture(GL_TEXTURE_BUFFER, m_Texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_Buffer);
+    GLState::bindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+TransformBatch::~TransformBatch()
+{
+    GLState::deleteTextures(1, &m_Texture);
+    glDeleteBuffers(1, &m_Buffer);
+}
+
+void TransformBatch::clear()
+{
+    m_PosX.clear(); m_PosY.clear(); m_PosZ.clear();
+    m_RotX.clear(); m_RotY.clear(); m_RotZ.clear();
+    m_ScaleX.clear(); m_ScaleY.clear(); m_ScaleZ.clear();
+    m_UVRects.clear();
+    m_Layers.clear();
+}
+
+int TransformBatch::add(const glm::vec3& position, const glm::vec3& rotation, const glm::vec3& scale,
+    const glm::vec4& uvRect, int layer)
+{
+    m_PosX.push_back(position.x); m_PosY.push_back(position.y); m_PosZ.push_back(position.z);
+    m_RotX.push_back(glm::radians(rotation.x)); m_RotY.push_back(glm::radians(rotation.y)); m_RotZ.push_back(glm::radians(rotation.z));
+    m_ScaleX.push_back(scale.x); m_ScaleY.push_back(scale.y); m_ScaleZ.push_back(scale.z);
+    m_UVRects.push_back(uvRect);
+    m_Layers.push_back((float)layer);
+    return (int)m_PosX.size() - 1;
+}
+
+void TransformBatch::update(const glm::mat4& view, const glm::mat4& projection, const glm::vec2& jitter)
+{
+    size_t count = size();
+    m_Output.resize(count * TRANSFORM_TEXELS);
+    if (count == 0)
+        return;
+
+    // x += jitter.x * w (and y alike) shifts NDC by the jitter
+    glm::mat4 jitterOffset(1.0f);
+    jitterOffset[3][0] = jitter.x;
+    jitterOffset[3][1] = jitter.y;
+    glm::mat4 viewProjection = jitterOffset * projection * view;
+#ifdef TRANSFORM_BATCH_SSE
+    size_t simdCount = count & ~size_t(3);
+    computeSIMD(simdCount, viewProjection);
+    computeScalar(simdCount, count, viewProjection);
+#else
+    computeScalar(0, count, viewProjection);
+#endif
+    std::vector<glm::vec4> currentMVP(count * 4);
+    for (size_t i = 0; i < count; i++)
+    {
+        glm::vec4* out = &m_Output[i * TRANSFORM_TEXELS];
+        out[8].w = m_Layers[i];
+        out[11] = m_UVRects[i];
+        bool hasPrevious = (i + 1) * 4 <= m_PreviousMVP.size();
+        for (int c = 0; c < 4; c++)
+        {
+            glm::vec4 column = out[4 + c];
+            column.x -= jitter.x * column.w;
+            column.y -= jitter.y * column.w;
+            currentMVP[i * 4 + c] = column;
+            // a new object has no motion yet
+            out[12 + c] = hasPrevious ? m_PreviousMVP[i * 4 + c] : column;
+        }
+    }
+    m_PreviousMVP.swap(currentMVP);
+
+    // a larger buffer would be silently cut short when sampled
+    if (count > m_Capacity)
+    {
+        if (!m_OverCapacity)
+            std::cout << "TransformBatch: " << count << " objects exceed the texture buffer's " << m_Capacity
+                << ", not uploading" << std::endl;
+        m_OverCapacity = true;
+        return;
+    }
+    m_OverCapacity = false;
+
+    // orphan the previous contents instead of waiting for the GPU to finish with them
+    size_t bytes = m_Output.size() * sizeof(glm::vec4);
+    glBindBuffer(GL_TEXTURE_BUFFER, m_Buffer);
+    if (bytes > m_BufferSize)
+        m_BufferSize = bytes * 2;
+    glBufferData(GL_TEXTURE_BUFFER, m_BufferSize, NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_TEXTURE_BUFFER, 0, bytes, m_Output.data());
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void TransformBatch::bind() const
+{
+    GLState::activeTexture(GL_TEXTURE0 + TRANSFORM_TEXTURE_UNIT);
+    GLState::bindTexture(GL_TEXTURE_BUFFER, m_Texture);
+    GLState::activeTexture(GL_TEXTURE0);
+}
+
+// World = T * Rx * Ry * Rz * S. The rotation part is written out in closed
+// form, and because it is orthonormal the normal matrix is simply R * S^-1,
+// so no matrix inverse is needed anywhere.
+void TransformBatch::computeScalar(size_t first, size_t last, const glm::mat4& viewProjection)
+{
+    for (size_t i = first; i < last; i++)
+    {
+        float sa = sinf(m_RotX[i]), ca = cosf(m_RotX[i]);
+        float sb = sinf(m_RotY[i]), cb = cosf(m_RotY[i]);
+        float sc = sinf(m_RotZ[i]), cc = cosf(m_RotZ[i]);
+
+        glm::vec3 r0(cb * cc, ca * sc + sa * sb * cc, sa * sc - ca * sb * cc);
+        glm::vec3 r1(-cb * sc, ca * cc - sa * sb * sc, sa * cc + ca * sb * sc);
+        glm::vec3 r2(sb, -sa * cb, ca * cb);
+
+        glm::mat4 world(
+            glm::vec4(r0 * m_ScaleX[i], 0.0f),
+            glm::vec4(r1 * m_ScaleY[i], 0.0f),
+            glm::vec4(r2 * m_ScaleZ[i], 0.0f),
+            glm::vec4(m_PosX[i], m_PosY[i], m_PosZ[i], 1.0f));
+        glm::mat4 mvp = viewProjection * world;
+
+        glm::vec4* out = &m_Output[i * TRANSFORM_TEXELS];
+        for (int c = 0; c < 4; c++)
+        {
+            out[c] = world[c];
+            out[4 + c] = mvp[c];
+        }
+        out[8] = glm::vec4(r0 / m_ScaleX[i], 0.0f);
+        out[9] = glm::vec4(r1 / m_ScaleY[i], 0.0f);
+        out[10] = glm::vec4(r2 / m_ScaleZ[i], 0.0f);
+    }
+}
+
+#ifdef TRANSFORM_BATCH_SSE
+
+// Same math as computeScalar with one object per SSE lane. Every __m128
+// holds one matrix element for four objects; the results are transposed
+// back into per-object texels on the way out.
+void TransformBatch::computeSIMD(size_t count, const glm::mat4& viewProjection)
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 zero = _mm_setzero_ps();
+
+    for (size_t i = 0; i < count; i += 4)
+    {
+        // there is no SSE sin/cos, so the trig stays scalar
+        alignas(16) float sinA[4], cosA[4], sinB[4], cosB[4], sinC[4], cosC[4];
+        for (int l = 0; l < 4; l++)
+        {
+            sinA[l] = sinf(m_RotX[i + l]); cosA[l] = cosf(m_RotX[i + l]);
+            sinB[l] = sinf(m_RotY[i + l]); cosB[l] = cosf(m_RotY[i + l]);
+            sinC[l] = sinf(m_RotZ[i + l]); cosC[l] = cosf(m_RotZ[i + l]);
+        }
+        __m128 sa = _mm_load_ps(sinA), ca = _mm_load_ps(cosA);
+        __m128 sb = _mm_load_ps(sinB), cb = _mm_load_ps(cosB);
+        __m128 sc = _mm_load_ps(sinC), cc = _mm_load_ps(cosC);
+
+        __m128 sasb = _mm_mul_ps(sa, sb);
+        __m128 casb = _mm_mul_ps(ca, sb);
+
+        // r[column][row]
+        __m128 r[3][3];
+        r[0][0] = _mm_mul_ps(cb, cc);
+        r[0][1] = _mm_add_ps(_mm_mul_ps(ca, sc), _mm_mul_ps(sasb, cc));
+        r[0][2] = _mm_sub_ps(_mm_mul_ps(sa, sc), _mm_mul_ps(casb, cc));
+        r[1][0] = _mm_sub_ps(zero, _mm_mul_ps(cb, sc));
+        r[1][1] = _mm_sub_ps(_mm_mul_ps(ca, cc), _mm_mul_ps(sasb, sc));
+        r[1][2] = _mm_add_ps(_mm_mul_ps(sa, cc), _mm_mul_ps(casb, sc));
+        r[2][0] = sb;
+        r[2][1] = _mm_sub_ps(zero, _mm_mul_ps(sa, cb));
+        r[2][2] = _mm_mul_ps(ca, cb);
+
+        __m128 scale[3] = { _mm_loadu_ps(&m_ScaleX[i]), _mm_loadu_ps(&m_ScaleY[i]), _mm_loadu_ps(&m_ScaleZ[i]) };
+        __m128 position[3] = { _mm_loadu_ps(&m_PosX[i]), _mm_loadu_ps(&m_PosY[i]), _mm_loadu_ps(&m_PosZ[i]) };
+
+        // texel[t][component]: 11 texels of 4 components, each for four objects
+        __m128 texel[MATRIX_TEXELS][4];
+        for (int c = 0; c < 3; c++)
+        {
+            __m128 inverseScale = _mm_div_ps(one, scale[c]);
+            for (int row = 0; row < 3; row++)
+            {
+                texel[c][row] = _mm_mul_ps(r[c][row], scale[c]);
+                texel[8 + c][row] = _mm_mul_ps(r[c][row], inverseScale);
+            }
+            texel[c][3] = zero;
+            texel[8 + c][3] = zero;
+        }
+        texel[3][0] = position[0];
+        texel[3][1] = position[1];
+        texel[3][2] = position[2];
+        texel[3][3] = one;
+
+        // MVP column c = viewProjection * world column c
+        for (int c = 0; c < 4; c++)
+        {
+            for (int row = 0; row < 4; row++)
+            {
+                __m128 sum = _mm_mul_ps(_mm_set1_ps(viewProjection[0][row]), texel[c][0]);
+                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(viewProjection[1][row]), texel[c][1]));
+                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(viewProjection[2][row]), texel[c][2]));
+                if (c == 3)
+                    sum = _mm_add_ps(sum, _mm_set1_ps(viewProjection[3][row]));
+                texel[4 + c][row] = sum;
+            }
+        }
+
+        // SoA -> one vec4 per object
+        for (int t = 0; t < MATRIX_TEXELS; t++)
+        {
+            __m128 x = texel[t][0], y = texel[t][1], z = texel[t][2], w = texel[t][3];
+            _MM_TRANSPOSE4_PS(x, y, z, w);
+            _mm_storeu_ps(&m_Output[(i + 0) * TRANSFORM_TEXELS + t].x, x);
+            _mm_storeu_ps(&m_Output[(i + 1) * TRANSFORM_TEXELS + t].x, y);
+            _mm_storeu_ps(&m_Output[(i + 2) * TRANSFORM_TEXELS + t].x, z);
+            _mm_storeu_ps(&m_Output[(i + 3) * TRANSFORM_TEXELS + t].x, w);
+        }
+    }
+}
+
+#else
+
+void TransformBatch::computeSIMD(size_t count, const glm::mat4& viewProjection)
+{
+    computeScalar(0, count, viewProjection);
+}
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef TRANSFORM_BATCH_H
+#define TRANSFORM_BATCH_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+// Texture unit the transform buffer is bound to while drawing
+const unsigned int TRANSFORM_TEXTURE_UNIT = 1;
+// vec4 texels per object: world (4), MVP (4), normal matrix (3), texture
+// rectangle (1), previous frame's MVP (4). The unused .w of the first normal
+// matrix texel holds the texture array layer.
+const int TRANSFORM_TEXELS = 16;
+
+// Per-frame world, MVP and normal matrices for every drawn object.
+// Objects are added as translate/rotate/scale values stored in SoA arrays,
+// all matrices are computed together (four objects per SSE operation) and
+// the result is uploaded once into a texture buffer that shader.vert reads
+// with texelFetch(transforms, drawIndex * TRANSFORM_TEXELS + n).
+class TransformBatch {
+public:
+    TransformBatch();
+    ~TransformBatch();
+
+    TransformBatch(const TransformBatch&) = delete;
+    TransformBatch& operator=(const TransformBatch&) = delete;
+
+    void clear();
+    // Rotation in degrees, applied X then Y then Z like glm::rotate chains.
+    // uvRect and layer locate the object's texture in a texture array
+    // (see TextureSlot). Returns the draw index to pass to the shader.
+    int add(const glm::vec3& position, const glm::vec3& rotation, const glm::vec3& scale,
+        const glm::vec4& uvRect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f), int layer = 0);
+
+    // Computes every matrix and uploads the buffer; refuses (and logs) the
+    // upload when there are more objects than getCapacity(). jitter is an
+    // NDC offset added to this frame's MVPs (see TemporalAA); the
+    // previous-frame MVPs kept for motion vectors are stored without it.
+    // They are matched by draw index, so objects must be added in the same
+    // order every frame.
+    void update(const glm::mat4& view, const glm::mat4& projection, const glm::vec2& jitter = glm::vec2(0.0f));
+    void bind() const;
+
+    size_t size() const { return m_PosX.size(); }
+    // Objects the texture buffer can hold, from GL_MAX_TEXTURE_BUFFER_SIZE
+    // (65536 texels, 4096 objects, guaranteed by GL 3.3)
+    size_t getCapacity() const { return m_Capacity; }
+    // World matrix computed by the last update()
+    glm::mat4 getWorld(int drawIndex) const
+    {
+        const glm::vec4* texels = &m_Output[(size_t)drawIndex * TRANSFORM_TEXELS];
+        return glm::mat4(texels[0], texels[1], texels[2], texels[3]);
+    }
+
+private:
+    std::vector<float> m_PosX, m_PosY, m_PosZ;
+    std::vector<float> m_RotX, m_RotY, m_RotZ;
+    std::vector<float> m_ScaleX, m_ScaleY, m_ScaleZ;
+    std::vector<glm::vec4> m_UVRects;
+    std::vector<float> m_Layers;
+    std::vector<glm::vec4> m_Output;
+    // last frame's unjittered MVP columns, four per object
+    std::vector<glm::vec4> m_PreviousMVP;
+
+    unsigned int m_Buffer;
+    unsigned int m_Texture;
+    size_t m_BufferSize;
+    size_t m_Capacity;
+    bool m_OverCapacity;
+
+    void computeScalar(size_t first, size_t last, const glm::mat4& viewProjection);
+    void computeSIMD(size_t count, const glm::mat4& viewProjection);
+};
+
+#endif // TRANSFORM_BATCH_H
@@ -0,0 +1,429 @@
+#include "VirtualTexture.h"
+#include "GLState.h"
+#include "Texture.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <unordered_set>
+
+VirtualTexture::VirtualTexture(const std::string& path, int cachePagesPerSide, int threads)
+    : m_Path(path), m_CacheID(0), m_IndirectionID(0), m_CachePagesPerSide(std::min(std::max(cachePagesPerSide, 2), 256)),
+    m_IndirectionDirty(false), m_ResidentPages(0), m_Frame(0),
+    m_FeedbackFBO(0), m_FeedbackColor(0), m_FeedbackDepth(0), m_FeedbackWidth(0), m_FeedbackHeight(0),
+    m_FeedbackWrite(0), m_RequestedLastFeedback(0), m_Stop(false), m_Loading(0), m_UploadedLastFrame(0)
+{
+    for (int i = 0; i < FEEDBACK_BUFFERS; i++)
+    {
+        m_FeedbackPBO[i] = 0;
+        m_FeedbackFences[i] = 0;
+        m_FeedbackSize[i][0] = m_FeedbackSize[i][1] = 0;
+    }
+
+    if (!readVirtualTextureLayout(path, m_Layout))
+    {
+        std::cout << "Failed to load virtual texture: " << path << std::endl;
+        return;
+    }
+    if (!isBlockFormatSupported(m_Layout.format))
+    {
+        std::cout << blockFormatName(m_Layout.format) << " is not supported by the driver, skipping " << path << std::endl;
+        return;
+    }
+
+    // the last mip is a single page that stays resident as the fallback for everything
+    std::vector<uint8_t> rootTile;
+    std::ifstream file(path, std::ios::binary);
+    if (!readVirtualTextureTile(file, m_Layout, m_Layout.pageCount() - 1, rootTile))
+    {
+        std::cout << "Failed to read virtual texture: " << path << std::endl;
+        return;
+    }
+
+    int first = 0;
+    for (int mip = 0; mip < m_Layout.mipCount; mip++)
+    {
+        m_MipFirstPage.push_back(first);
+        first += m_Layout.pagesAtMip(mip) * m_Layout.pagesAtMip(mip);
+    }
+    m_PageSlot.assign(m_Layout.pageCount(), -1);
+    m_PageLoading.assign(m_Layout.pageCount(), false);
+    m_Slots.resize((size_t)m_CachePagesPerSide * m_CachePagesPerSide);
+
+    int cacheSize = m_CachePagesPerSide * m_Layout.paddedTileSize();
+    glGenTextures(1, &m_CacheID);
+    GLState::bindTexture(GL_TEXTURE_2D, m_CacheID);
+    glCompressedTexImage2D(GL_TEXTURE_2D, 0, m_Layout.glInternalFormat, cacheSize, cacheSize, 0,
+        (GLsizei)compressedSize(cacheSize, cacheSize, m_Layout.format), NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+
+    // one texel per page, one level per mip; only ever read with texelFetch
+    glGenTextures(1, &m_IndirectionID);
+    GLState::bindTexture(GL_TEXTURE_2D, m_IndirectionID);
+    for (int mip = 0; mip < m_Layout.mipCount; mip++)
+    {
+        int pages = m_Layout.pagesAtMip(mip);
+        m_Indirection.emplace_back((size_t)pages * pages * 4, 0);
+        glTexImage2D(GL_TEXTURE_2D, mip, GL_RGBA8, pages, pages, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, m_Layout.mipCount - 1);
+    GLState::bindTexture(GL_TEXTURE_2D, 0);
+
+    uploadPage(0, m_Layout.pageCount() - 1, rootTile);
+    m_Slots[0].pinned = true;
+    rebuildIndirection();
+
+    glGenBuffers(FEEDBACK_BUFFERS, m_FeedbackPBO);
+    for (int i = 0; i < std::max(threads, 1); i++)
+        m_Workers.emplace_back(&VirtualTexture::workerLoop, this);
+}
+
+VirtualTexture::~VirtualTexture()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stop = true;
+    }
+    m_Wake.notify_all();
+    for (std::thread& worker : m_Workers)
+        worker.join();
+
+    for (int i = 0; i < FEEDBACK_BUFFERS; i++)
+    {
+        if (m_FeedbackFences[i])
+            glDeleteSync(m_FeedbackFences[i]);
+    }
+    glDeleteBuffers(FEEDBACK_BUFFERS, m_FeedbackPBO);
+    GLState::deleteFramebuffers(1, &m_FeedbackFBO);
+    GLState::deleteTextures(1, &m_FeedbackColor);
+    glDeleteRenderbuffers(1, &m_FeedbackDepth);
+    GLState::deleteTextures(1, &m_CacheID);
+    GLState::deleteTextures(1, &m_IndirectionID);
+}
+
+bool VirtualTexture::beginFeedback(int screenWidth, int screenHeight)
+{
+    if (!isValid() || m_FeedbackFences[m_FeedbackWrite])
+        return false;
+
+    int width = std::max(screenWidth / FEEDBACK_DIVISOR, 1);
+    int height = std::max(screenHeight / FEEDBACK_DIVISOR, 1);
+    if (width != m_FeedbackWidth || height != m_FeedbackHeight)
+    {
+        if (!m_FeedbackFBO)
+        {
+            glGenFramebuffers(1, &m_FeedbackFBO);
+            glGenTextures(1, &m_FeedbackColor);
+            glGenRenderbuffers(1, &m_FeedbackDepth);
+        }
+        GLState::bindTexture(GL_TEXTURE_2D, m_FeedbackColor);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        GLState::bindTexture(GL_TEXTURE_2D, 0);
+        glBindRenderbuffer(GL_RENDERBUFFER, m_FeedbackDepth);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+        GLState::bindFramebuffer(GL_FRAMEBUFFER, m_FeedbackFBO);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_FeedbackColor, 0);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_FeedbackDepth);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "Virtual texture feedback framebuffer not complete!" << std::endl;
+        GLState::bindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        m_FeedbackWidth = width;
+        m_FeedbackHeight = height;
+    }
+
+    glGetIntegerv(GL_VIEWPORT, m_SavedViewport);
+    GLState::bindFramebuffer(GL_FRAMEBUFFER, m_FeedbackFBO);
+    glViewport(0, 0, width, height);
+    // alpha 0 marks pixels that need nothing
+    GLfloat clearColor[4];
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+    return true;
+}
+
+void VirtualTexture::endFeedback()
+{
+    // read into a buffer now, map it a few frames later once the fence has passed
+    int index = m_FeedbackWrite;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_FeedbackPBO[index]);
+    if (m_FeedbackSize[index][0] != m_FeedbackWidth || m_FeedbackSize[index][1] != m_FeedbackHeight)
+    {
+        glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)m_FeedbackWidth * m_FeedbackHeight * 4, NULL, GL_STREAM_READ);
+        m_FeedbackSize[index][0] = m_FeedbackWidth;
+        m_FeedbackSize[index][1] = m_FeedbackHeight;
+    }
+    glReadPixels(0, 0, m_FeedbackWidth, m_FeedbackHeight, GL_RGBA, GL_UNSIGNED_BYTE, (void*)0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    m_FeedbackFences[index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    m_FeedbackWrite = (m_FeedbackWrite + 1) % FEEDBACK_BUFFERS;
+
+    GLState::bindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(m_SavedViewport[0], m_SavedViewport[1], m_SavedViewport[2], m_SavedViewport[3]);
+}
+
+void VirtualTexture::setUniforms(const Shader& shader, bool feedback) const
+{
+    // the feedback buffer is FEEDBACK_DIVISOR times smaller, so its derivatives
+    // are that much larger than on screen
+    float lodBias = feedback ? -log2((float)FEEDBACK_DIVISOR) : 0.0f;
+    float cacheSize = (float)(m_CachePagesPerSide * m_Layout.paddedTileSize());
+    shader.setInt("vtCache"_u, VIRTUAL_CACHE_UNIT);
+    shader.setInt("vtIndirection"_u, VIRTUAL_INDIRECTION_UNIT);
+    shader.setVec4("vtLayout"_u, glm::vec4((float)m_Layout.virtualSize(), (float)m_Layout.pagesPerSide,
+        (float)(m_Layout.mipCount - 1), lodBias));
+    shader.setVec4("vtCacheLayout"_u, glm::vec4((float)m_Layout.tileSize, (float)m_Layout.border,
+        (float)m_Layout.paddedTileSize(), 1.0f / cacheSize));
+}
+
+void VirtualTexture::bind() const
+{
+    GLState::activeTexture(GL_TEXTURE0 + VIRTUAL_CACHE_UNIT);
+    GLState::bindTexture(GL_TEXTURE_2D, m_CacheID);
+    GLState::activeTexture(GL_TEXTURE0 + VIRTUAL_INDIRECTION_UNIT);
+    GLState::bindTexture(GL_TEXTURE_2D, m_IndirectionID);
+    GLState::activeTexture(GL_TEXTURE0);
+}
+
+void VirtualTexture::update()
+{
+    m_UploadedLastFrame = 0;
+    if (!isValid())
+        return;
+    m_Frame++;
+
+    // readbacks complete in the order they were issued, oldest first
+    for (int i = 0; i < FEEDBACK_BUFFERS; i++)
+    {
+        int index = (m_FeedbackWrite + i) % FEEDBACK_BUFFERS;
+        if (!m_FeedbackFences[index])
+            continue;
+        if (glClientWaitSync(m_FeedbackFences[index], 0, 0) == GL_TIMEOUT_EXPIRED)
+            break;
+        glDeleteSync(m_FeedbackFences[index]);
+        m_FeedbackFences[index] = 0;
+
+        int width = m_FeedbackSize[index][0], height = m_FeedbackSize[index][1];
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, m_FeedbackPBO[index]);
+        const uint8_t* pixels = (const uint8_t*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)width * height * 4, GL_MAP_READ_BIT);
+        if (pixels)
+            readFeedback(pixels, width, height);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    std::vector<LoadedPage> loaded;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        while (!m_Loaded.empty() && (int)loaded.size() < MAX_UPLOADS_PER_FRAME)
+        {
+            loaded.push_back(std::move(m_Loaded.front()));
+            m_Loaded.pop_front();
+        }
+    }
+    for (LoadedPage& page : loaded)
+    {
+        m_PageLoading[page.page] = false;
+        m_Loading--;
+        if (!page.ok)
+        {
+            std::cout << "Failed to read page " << page.page << " of " << m_Path << std::endl;
+            continue;
+        }
+        // with every page in use the load is dropped; feedback asks for it again
+        int slot = allocateSlot();
+        if (slot < 0)
+            continue;
+        uploadPage(slot, page.page, page.data);
+        m_UploadedLastFrame++;
+    }
+
+    if (m_IndirectionDirty)
+        rebuildIndirection();
+}
+
+void VirtualTexture::readFeedback(const uint8_t* pixels, int width, int height)
+{
+    // every needed page and its ancestors, which are what gets drawn until it arrives
+    std::unordered_set<int> visited;
+    std::vector<int> wanted;
+    for (int i = 0; i < width * height; i++)
+    {
+        const uint8_t* texel = pixels + (size_t)i * 4;
+        int mip = texel[2];
+        if (texel[3] != 255 || mip >= m_Layout.mipCount)
+            continue;
+        int pages = m_Layout.pagesAtMip(mip);
+        if (texel[0] >= pages || texel[1] >= pages)
+            continue;
+
+        for (int page = m_MipFirstPage[mip] + texel[1] * pages + texel[0]; page >= 0 && visited.insert(page).second; page = parentPage(page))
+        {
+            if (m_PageSlot[page] >= 0)
+                touchPage(page);
+            else if (!m_PageLoading[page])
+                wanted.push_back(page);
+        }
+    }
+    m_RequestedLastFeedback = (int)visited.size();
+
+    // coarse pages first: they cover the most screen and are the next fallback
+    std::stable_sort(wanted.begin(), wanted.end(), [this](int a, int b) { return pageMip(a) > pageMip(b); });
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        for (int page : wanted)
+        {
+            if (m_Loading >= MAX_PENDING_LOADS)
+                break;
+            m_LoadQueue.push_back(page);
+            m_PageLoading[page] = true;
+            m_Loading++;
+        }
+    }
+    m_Wake.notify_all();
+}
+
+void VirtualTexture::touchPage(int page)
+{
+    m_Slots[m_PageSlot[page]].lastUsed = m_Frame;
+}
+
+int VirtualTexture::pageMip(int page) const
+{
+    int mip = m_Layout.mipCount - 1;
+    while (mip > 0 && page < m_MipFirstPage[mip])
+        mip--;
+    return mip;
+}
+
+int VirtualTexture::parentPage(int page) const
+{
+    int mip = pageMip(page);
+    if (mip == m_Layout.mipCount - 1)
+        return -1;
+    int pages = m_Layout.pagesAtMip(mip);
+    int local = page - m_MipFirstPage[mip];
+    int x = local % pages, y = local / pages;
+    return m_MipFirstPage[mip + 1] + (y / 2) * (pages / 2) + x / 2;
+}
+
+int VirtualTexture::allocateSlot()
+{
+    // a free slot, else the least recently needed page not needed this frame
+    int victim = -1;
+    for (int i = 0; i < (int)m_Slots.size(); i++)
+    {
+        const Slot& slot = m_Slots[i];
+        if (slot.page < 0)
+            return i;
+        if (slot.pinned || slot.lastUsed >= m_Frame)
+            continue;
+        if (victim < 0 || slot.lastUsed < m_Slots[victim].lastUsed)
+            victim = i;
+    }
+    if (victim >= 0)
+    {
+        m_PageSlot[m_Slots[victim].page] = -1;
+        m_Slots[victim].page = -1;
+        m_ResidentPages--;
+        m_IndirectionDirty = true;
+    }
+    return victim;
+}
+
+void VirtualTexture::uploadPage(int slot, int page, const std::vector<uint8_t>& data)
+{
+    int padded = m_Layout.paddedTileSize();
+    int x = slot % m_CachePagesPerSide, y = slot / m_CachePagesPerSide;
+    GLState::bindTexture(GL_TEXTURE_2D, m_CacheID);
+    glCompressedTexSubImage2D(GL_TEXTURE_2D, 0, x * padded, y * padded, padded, padded,
+        m_Layout.glInternalFormat, (GLsizei)data.size(), data.data());
+    GLState::bindTexture(GL_TEXTURE_2D, 0);
+
+    m_Slots[slot].page = page;
+    m_Slots[slot].lastUsed = m_Frame;
+    m_PageSlot[page] = slot;
+    m_ResidentPages++;
+    m_IndirectionDirty = true;
+}
+
+void VirtualTexture::rebuildIndirection()
+{
+    // coarsest first, so a missing page can copy its parent's entry
+    GLState::bindTexture(GL_TEXTURE_2D, m_IndirectionID);
+    for (int mip = m_Layout.mipCount - 1; mip >= 0; mip--)
+    {
+        int pages = m_Layout.pagesAtMip(mip);
+        std::vector<uint8_t>& level = m_Indirection[mip];
+        for (int y = 0; y < pages; y++)
+        {
+            for (int x = 0; x < pages; x++)
+            {
+                uint8_t* entry = &level[((size_t)y * pages + x) * 4];
+                int slot = m_PageSlot[m_MipFirstPage[mip] + y * pages + x];
+                if (slot >= 0)
+                {
+                    entry[0] = (uint8_t)(slot % m_CachePagesPerSide);
+                    entry[1] = (uint8_t)(slot / m_CachePagesPerSide);
+                    entry[2] = (uint8_t)mip;
+                    entry[3] = 255;
+                }
+                else
+                {
+                    const uint8_t* parent = &m_Indirection[mip + 1][((size_t)(y / 2) * (pages / 2) + x / 2) * 4];
+                    std::copy(parent, parent + 4, entry);
+                }
+            }
+        }
+        glTexSubImage2D(GL_TEXTURE_2D, mip, 0, 0, pages, pages, GL_RGBA, GL_UNSIGNED_BYTE, level.data());
+    }
+    GLState::bindTexture(GL_TEXTURE_2D, 0);
+    m_IndirectionDirty = false;
+}
+
+size_t VirtualTexture::getMemoryUsage() const
+{
+    if (!isValid())
+        return 0;
+    int cacheSize = m_CachePagesPerSide * m_Layout.paddedTileSize();
+    size_t bytes = compressedSize(cacheSize, cacheSize, m_Layout.format);
+    for (const std::vector<uint8_t>& level : m_Indirection)
+        bytes += level.size();
+    return bytes;
+}
+
+void VirtualTexture::workerLoop()
+{
+    std::ifstream file(m_Path, std::ios::binary);
+    while (true)
+    {
+        int page = 0;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Wake.wait(lock, [this] { return m_Stop || !m_LoadQueue.empty(); });
+            if (m_Stop)
+                return;
+            page = m_LoadQueue.front();
+            m_LoadQueue.pop_front();
+        }
+
+        LoadedPage loaded;
+        loaded.page = page;
+        loaded.ok = file && readVirtualTextureTile(file, m_Layout, page, loaded.data);
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Loaded.push_back(std::move(loaded));
+    }
+}
@@ -0,0 +1,126 @@
+#ifndef VIRTUAL_TEXTURE_H
+#define VIRTUAL_TEXTURE_H
+
+#include <glad/glad.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Shader.h"
+#include "VirtualTextureFile.h"
+
+// Texture units the page cache and the indirection table are bound to
+const unsigned int VIRTUAL_CACHE_UNIT = 3;
+const unsigned int VIRTUAL_INDIRECTION_UNIT = 4;
+
+// A texture far larger than VRAM, streamed from a tiled page file by
+// visibility. Each frame the surfaces using it are drawn into a small
+// feedback buffer with vt_feedback.frag, which writes the page and mip every
+// pixel needs. The buffer is read back asynchronously; missing pages are
+// read from disk on worker threads and copied into a fixed pool of physical
+// pages (the cache), least recently needed pages making way. An indirection
+// texture with one texel per page and mip maps virtual pages to cache slots,
+// pages not resident yet pointing at their nearest resident ancestor, so
+// detail only ever sharpens in. The single page of the last mip is loaded
+// up front and never evicted.
+class VirtualTexture {
+public:
+    // cachePagesPerSide^2 pages of physical memory (at most 256 per side)
+    VirtualTexture(const std::string& path, int cachePagesPerSide = 16, int threads = 2);
+    ~VirtualTexture();
+
+    VirtualTexture(const VirtualTexture&) = delete;
+    VirtualTexture& operator=(const VirtualTexture&) = delete;
+
+    // False if the page file is missing or its format is unsupported
+    bool isValid() const { return m_CacheID != 0; }
+
+    // Draw everything sampling this texture with the feedback shader between
+    // these two. beginFeedback returns false (skip the pass) while every
+    // readback buffer is still in flight.
+    bool beginFeedback(int screenWidth, int screenHeight);
+    void endFeedback();
+
+    // Sets the vt* uniforms of the lit shader's USE_VIRTUAL_TEXTURE variant
+    // or of the feedback shader
+    void setUniforms(const Shader& shader, bool feedback) const;
+    void bind() const;
+
+    // Consumes finished feedback, queues page loads and uploads loaded pages;
+    // once per frame on the GL thread
+    void update();
+
+    const VirtualTextureLayout& getLayout() const { return m_Layout; }
+    int getResidentPages() const { return m_ResidentPages; }
+    int getCachePages() const { return (int)m_Slots.size(); }
+    size_t getPendingPages() const { return m_Loading; }
+    int getUploadedLastFrame() const { return m_UploadedLastFrame; }
+    int getRequestedLastFeedback() const { return m_RequestedLastFeedback; }
+    size_t getMemoryUsage() const;
+
+private:
+    static const int FEEDBACK_DIVISOR = 8;
+    static const int FEEDBACK_BUFFERS = 3;
+    static const size_t MAX_PENDING_LOADS = 64;
+    static const int MAX_UPLOADS_PER_FRAME = 16;
+
+    struct Slot {
+        int page = -1;
+        unsigned int lastUsed = 0;
+        bool pinned = false;
+    };
+
+    struct LoadedPage {
+        int page;
+        std::vector<uint8_t> data;
+        bool ok;
+    };
+
+    std::string m_Path;
+    VirtualTextureLayout m_Layout;
+    std::vector<int> m_MipFirstPage;
+
+    unsigned int m_CacheID;
+    unsigned int m_IndirectionID;
+    int m_CachePagesPerSide;
+    std::vector<Slot> m_Slots;
+    std::vector<int> m_PageSlot;   // per page, -1 when not resident
+    std::vector<bool> m_PageLoading;
+    std::vector<std::vector<uint8_t>> m_Indirection; // RGBA8 per mip
+    bool m_IndirectionDirty;
+    int m_ResidentPages;
+    unsigned int m_Frame;
+
+    // feedback
+    unsigned int m_FeedbackFBO, m_FeedbackColor, m_FeedbackDepth;
+    int m_FeedbackWidth, m_FeedbackHeight;
+    unsigned int m_FeedbackPBO[FEEDBACK_BUFFERS];
+    GLsync m_FeedbackFences[FEEDBACK_BUFFERS];
+    int m_FeedbackSize[FEEDBACK_BUFFERS][2];
+    int m_FeedbackWrite;
+    GLint m_SavedViewport[4];
+    int m_RequestedLastFeedback;
+
+    // page loading
+    std::vector<std::thread> m_Workers;
+    std::mutex m_Mutex;
+    std::condition_variable m_Wake;
+    std::deque<int> m_LoadQueue;
+    std::deque<LoadedPage> m_Loaded;
+    bool m_Stop;
+    size_t m_Loading;
+    int m_UploadedLastFrame;
+
+    void workerLoop();
+    void readFeedback(const uint8_t* pixels, int width, int height);
+    void touchPage(int page);
+    int parentPage(int page) const;
+    int pageMip(int page) const;
+    int allocateSlot();
+    void uploadPage(int slot, int page, const std::vector<uint8_t>& data);
+    void rebuildIndirection();
+};
+
+#endif // VIRTUAL_TEXTURE_H
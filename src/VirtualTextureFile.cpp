@@ -0,0 +1,118 @@
+#include "VirtualTextureFile.h"
+#include <cstring>
+#include <fstream>
+
+namespace {
+    const uint8_t PAGE_FILE_IDENTIFIER[12] = { 0xAB, 'V', 'T', 'P', ' ', '1', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+    // the feedback pass stores page coordinates and mips in 8 bits each
+    const int MAX_PAGES_PER_SIDE = 256;
+
+    struct PageFileHeader {
+        uint8_t identifier[12];
+        uint32_t glInternalFormat;
+        uint32_t blockFormat;
+        uint32_t tileSize;
+        uint32_t border;
+        uint32_t pagesPerSide;
+        uint32_t mipCount;
+    };
+
+    uint64_t dataStart()
+    {
+        return (sizeof(PageFileHeader) + 15) & ~15ull;
+    }
+
+    bool isPowerOfTwo(int value)
+    {
+        return value > 0 && (value & (value - 1)) == 0;
+    }
+}
+
+int VirtualTextureLayout::pageCount() const
+{
+    int count = 0;
+    for (int mip = 0; mip < mipCount; mip++)
+        count += pagesAtMip(mip) * pagesAtMip(mip);
+    return count;
+}
+
+int VirtualTextureLayout::pageIndex(int mip, int x, int y) const
+{
+    int index = 0;
+    for (int level = 0; level < mip; level++)
+        index += pagesAtMip(level) * pagesAtMip(level);
+    return index + y * pagesAtMip(mip) + x;
+}
+
+bool writeVirtualTexture(const std::string& path, const VirtualTextureLayout& layout,
+    const std::function<std::vector<uint8_t>(int mip, int x, int y)>& encodeTile)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+        return false;
+
+    PageFileHeader header;
+    memcpy(header.identifier, PAGE_FILE_IDENTIFIER, sizeof(header.identifier));
+    header.glInternalFormat = layout.glInternalFormat;
+    header.blockFormat = (uint32_t)layout.format;
+    header.tileSize = (uint32_t)layout.tileSize;
+    header.border = (uint32_t)layout.border;
+    header.pagesPerSide = (uint32_t)layout.pagesPerSide;
+    header.mipCount = (uint32_t)layout.mipCount;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    static const char padding[16] = {};
+    file.write(padding, (std::streamsize)(dataStart() - sizeof(header)));
+    for (int mip = 0; mip < layout.mipCount; mip++)
+    {
+        for (int y = 0; y < layout.pagesAtMip(mip); y++)
+        {
+            for (int x = 0; x < layout.pagesAtMip(mip); x++)
+            {
+                std::vector<uint8_t> tile = encodeTile(mip, x, y);
+                if (tile.size() != layout.tileBytes())
+                    return false;
+                file.write(reinterpret_cast<const char*>(tile.data()), (std::streamsize)tile.size());
+            }
+        }
+    }
+    return (bool)file;
+}
+
+bool readVirtualTextureLayout(const std::string& path, VirtualTextureLayout& layout)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+
+    PageFileHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        memcmp(header.identifier, PAGE_FILE_IDENTIFIER, sizeof(header.identifier)) != 0)
+        return false;
+    if (header.blockFormat > (uint32_t)BlockFormat::BC7 || header.tileSize == 0 || header.tileSize % 4 != 0 ||
+        header.border % 2 != 0 || header.pagesPerSide > MAX_PAGES_PER_SIDE || !isPowerOfTwo((int)header.pagesPerSide) ||
+        header.mipCount == 0 || header.mipCount > 9)
+        return false;
+
+    layout.format = (BlockFormat)header.blockFormat;
+    layout.glInternalFormat = header.glInternalFormat;
+    layout.tileSize = (int)header.tileSize;
+    layout.border = (int)header.border;
+    layout.pagesPerSide = (int)header.pagesPerSide;
+    layout.mipCount = (int)header.mipCount;
+    if (layout.pagesAtMip(layout.mipCount - 1) != 1)
+        return false;
+
+    // the file must hold every tile
+    file.seekg(0, std::ios::end);
+    uint64_t expected = dataStart() + (uint64_t)layout.pageCount() * layout.tileBytes();
+    return (uint64_t)file.tellg() >= expected;
+}
+
+bool readVirtualTextureTile(std::istream& file, const VirtualTextureLayout& layout, int page, std::vector<uint8_t>& data)
+{
+    data.resize(layout.tileBytes());
+    file.clear();
+    file.seekg((std::streamoff)(dataStart() + (uint64_t)page * data.size()));
+    return (bool)file.read(reinterpret_cast<char*>(data.data()), (std::streamsize)data.size());
+}
@@ -0,0 +1,51 @@
+#ifndef VIRTUAL_TEXTURE_FILE_H
+#define VIRTUAL_TEXTURE_FILE_H
+
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <string>
+#include <vector>
+#include "TextureEncoder.h"
+
+// Tiled page file for VirtualTexture, written by "TextureCooker --virtual".
+//
+// The virtual texture is square, pagesPerSide pages of tileSize texels at
+// mip 0, halving per mip down to a single page. Every page is stored with a
+// border of neighbouring texels so it can be filtered on its own, and block
+// compressed, so all tiles have the same size and are found by index alone.
+//
+// File layout (".vtp", little endian):
+//   12-byte identifier "\xABVTP 10\xBB\r\n\x1A\n"
+//   uint32 glInternalFormat, blockFormat, tileSize, border, pagesPerSide, mipCount
+//   tiles from mip 0 to the last, each mip row by row, starting on a 16-byte
+//   boundary after the header
+struct VirtualTextureLayout {
+    BlockFormat format = BlockFormat::BC1;
+    unsigned int glInternalFormat = 0;
+    int tileSize = 128;
+    int border = 4;
+    int pagesPerSide = 1;   // at mip 0; a power of two
+    int mipCount = 1;       // log2(pagesPerSide) + 1
+
+    int paddedTileSize() const { return tileSize + 2 * border; }
+    size_t tileBytes() const { return compressedSize(paddedTileSize(), paddedTileSize(), format); }
+    int pagesAtMip(int mip) const { return pagesPerSide >> mip; }
+    int virtualSize() const { return pagesPerSide * tileSize; }
+
+    // Pages of all mips numbered in file order
+    int pageCount() const;
+    int pageIndex(int mip, int x, int y) const;
+};
+
+// encodeTile returns the compressed padded tile; it is called in file order
+bool writeVirtualTexture(const std::string& path, const VirtualTextureLayout& layout,
+    const std::function<std::vector<uint8_t>(int mip, int x, int y)>& encodeTile);
+
+// Fails on a bad identifier, unknown format or inconsistent sizes
+bool readVirtualTextureLayout(const std::string& path, VirtualTextureLayout& layout);
+// Reads one tile from a stream opened on the file; safe to call from any
+// thread as long as each thread has its own stream
+bool readVirtualTextureTile(std::istream& file, const VirtualTextureLayout& layout, int page, std::vector<uint8_t>& data);
+
+#endif // VIRTUAL_TEXTURE_FILE_H
@@ -7,7 +7,23 @@
 #include "Camera.h"
 #include "Model.h"
 #include "Shader.h"
+#include "ShaderVariants.h"
 #include "BloomEffect.h"
+#include "PostProcess.h"
+#include "DynamicResolution.h"
+#include "AutoExposure.h"
+#include "TemporalAA.h"
+#include "FrameUniforms.h"
+#include "GLExtensions.h"
+#include "GLState.h"
+#include "FileWatcher.h"
+#include "TransformBatch.h"
+#include "RenderQueue.h"
+#include "InstanceBuffer.h"
+#include "TextureLoader.h"
+#include "TextureManager.h"
+#include "TexturePack.h"
+#include "VirtualTexture.h"
 
 #include "Terrain.h"
 //#include "Road.h"
@@ -104,6 +120,9 @@ int main()
 
     float terrainSize = 10.0f;
 
+    bool trilinearFiltering = true;
+    float anisotropy = 8.0f;
+
     // glfw: initialize and configure
     // ------------------------------
     glfwInit();
@@ -134,6 +153,8 @@ int main()
         std::cout << "Failed to initialize GLAD" << std::endl;
         return -1;
     }
+    loadGLExtensions((GLADloadproc)glfwGetProcAddress);
+    GLState::invalidate();
 
     glfwSetCursorPosCallback(window, mouse_callback);
     glfwSetMouseButtonCallback(window, mouse_button_callback);
@@ -141,19 +162,79 @@ int main()
     Terrain terrain(terrainSize, terrainSize);
     terrain.generate();
 
-    // Create shader program
-    Shader shader("Shaders/shader.vert", "Shaders/shader.frag");
-
-    Shader bloomShader("Shaders/bloom.vert", "Shaders/bloom.frag");
-    Shader blurShader("Shaders/blur.vert", "Shaders/blur.frag");
-    Shader finalShader("Shaders/final.vert", "Shaders/final.frag");
-
-    Texture terrainTexture("Textures/Grass.png");
+    // Create shader program; one variant per used combination of material features
+    // (the bloom and post programs are owned by BloomEffect and PostProcess)
+    // Programs created between beginBatch/endBatch are compiled in parallel by the driver
+    Shader::beginBatch();
+    ShaderVariants litShader("Shaders/shader.vert", "Shaders/shader.frag", litShaderKeys());
+    // the lit variants can all be drawn in the first frame, so build them up front
+    litShader.get(0);
+    litShader.get(MATERIAL_USE_TEXTURE);
+    litShader.get(MATERIAL_TEXTURE_ARRAY);
+    litShader.get(MATERIAL_VIRTUAL_TEXTURE);
+    // writes the virtual texture pages each pixel needs
+    Shader feedbackShader("Shaders/shader.vert", "Shaders/vt_feedback.frag");
+    // the scene is drawn into an HDR target, then bloomed, tone mapped and graded into
+    // the window by a single post pass;
+    // the targets of every pass come from the pool and follow the window size
+    RenderTargetPool renderTargets;
+    FrameGraph frameGraph(renderTargets);
+    BloomEffect bloom;
+    PostProcess postProcess;
+    AutoExposure autoExposure;
+    // jitters the projection and accumulates the scene over frames at window resolution
+    TemporalAA temporalAA(renderTargets);
+    // the scene resolution follows the measured GPU time; the post pass upscales it
+    DynamicResolution dynamicResolution;
+    int framebufferWidth = 0, framebufferHeight = 0;
+    Shader::endBatch();
+
+    // view/projection/light values shared by every program through the FrameData block
+    FrameUniforms frameUniforms;
+    // world/MVP/normal matrices of every object, computed together each frame
+    TransformBatch transforms;
+    RenderQueue renderQueue;
+    // per-instance draw indices of the instanced model batches
+    InstanceBuffer instances;
+    std::vector<int> instanceIndices;
+    // model of every draw index below the terrain's
+    std::vector<unsigned int> drawModels;
+
+    // edits to files in Shaders/ are recompiled in the background
+    FileWatcher shaderWatcher("Shaders");
+
+    // textures decode on worker threads and stream in over the first frames;
+    // a grey placeholder is bound until each one is uploaded
+    TextureLoader textureLoader;
+    TextureOptions textureOptions;
+    textureOptions.loader = &textureLoader;
+    // one shared texture per file, kept within a VRAM budget
+    TextureManager textureManager(256 * 1024 * 1024, textureOptions);
+
+    // textures packed by "TextureCooker --pack" are sampled from shared arrays,
+    // so draws using them need no rebinding; anything else is loaded on its own
+    TexturePack texturePack("Textures/Packed/textures.pack");
+
+    // unique terrain detail from "TextureCooker --virtual", streamed by what is
+    // visible; without it the terrain repeats Grass.png
+    VirtualTexture terrainVirtual("Textures/Virtual/terrain.vtp");
+
+    TextureSlot terrainSlot;
+    std::shared_ptr<Texture> terrainTexture;
+    if (!terrainVirtual.isValid() && !texturePack.find("Textures/Grass.png", terrainSlot))
+        terrainTexture = textureManager.acquire("Textures/Grass.png");
 
     // Load models
     std::vector<Model> models;
-    models.emplace_back("3D_Models/Back.obj", "Textures/Back.png");
-    //models.emplace_back("3D_Models/Horn.obj", "Textures/Horn_Texture.png");
+    auto loadModel = [&](const std::string& objPath, const std::string& texturePath) {
+        TextureSlot slot;
+        if (texturePack.find(texturePath, slot))
+            models.emplace_back(objPath, slot);
+        else
+            models.emplace_back(objPath, textureManager.acquire(texturePath));
+    };
+    loadModel("3D_Models/Back.obj", "Textures/Back.png");
+    //loadModel("3D_Models/Horn.obj", "Textures/Horn_Texture.png");
     // Add more models as needed
 
     // Initialize matrices
@@ -170,15 +251,22 @@ int main()
 
     float color[4] = { 0.8f, 0.3f, 0.02f, 1.0f };
     bool drawModel = true;
+    // copies of every model, laid out in a grid; drawn instanced
+    int modelCopies = 1;
+    BloomSettings bloomSettings;
+    PostSettings postSettings;
+    DynamicResolutionSettings resolutionSettings;
+    AutoExposureSettings exposureSettings;
+    TemporalAASettings taaSettings;
 
     // uncomment this call to draw in wireframe polygons.
-    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-    glPolygonMode(GL_FRONT_AND_BACK, GL_POINT);
-    glEnable(GL_PROGRAM_POINT_SIZE);
+    GLState::polygonMode(GL_FRONT_AND_BACK, GL_LINE);
+    GLState::polygonMode(GL_FRONT_AND_BACK, GL_POINT);
+    GLState::enable(GL_PROGRAM_POINT_SIZE);
 
     //-----------------------------------------------------------------------------------------
 
-    glEnable(GL_DEPTH_TEST);
+    GLState::enable(GL_DEPTH_TEST);
 
     float deltaTime = 0.0f;
     float lastFrame = 0.0f;
@@ -187,6 +275,12 @@ int main()
     // -----------
     while (!glfwWindowShouldClose(window))
     {
+        // ImGui and anything else outside GLState may have changed bindings
+        GLState::beginFrame();
+
+        // Uniform location lookups that reached the driver during the previous frame
+        unsigned int uniformQueries = Shader::getLocationQueryCount();
+        Shader::resetLocationQueryCount();
 
         // Calculate delta time for smooth animation
         float currentFrame = glfwGetTime();
@@ -197,43 +291,242 @@ int main()
         // -----
         processInput(window, deltaTime);
 
+        // shader hot reload
+        for (const std::string& file : shaderWatcher.pollChanges())
+        {
+            litShader.onFileChanged(file);
+            if (feedbackShader.usesFile(file))
+                feedbackShader.beginReload();
+            bloom.onFileChanged(file);
+            postProcess.onFileChanged(file);
+            autoExposure.onFileChanged(file);
+            temporalAA.onFileChanged(file);
+        }
+        litShader.pollReload();
+        feedbackShader.pollReload();
+        bloom.pollReload();
+        postProcess.pollReload();
+        autoExposure.pollReload();
+        temporalAA.pollReload();
+
+        // upload whatever the texture workers finished, within the per-frame budget
+        textureLoader.update();
+        textureManager.update();
+        terrainVirtual.update();
+
         // render
         // ------
-        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+        renderTargets.beginFrame(framebufferWidth, framebufferHeight);
+        // the 3D scene is rendered at a fraction of the window, picked from the
+        // GPU time of the frames before; post processing and the UI stay native
+        dynamicResolution.update(frameGraph.getGpuMilliseconds(), resolutionSettings);
+        int sceneWidth = dynamicResolution.scaled(renderTargets.getScreenWidth());
+        int sceneHeight = dynamicResolution.scaled(renderTargets.getScreenHeight());
+        glm::vec2 jitter = temporalAA.beginFrame(taaSettings, sceneWidth, sceneHeight,
+            renderTargets.getScreenWidth(), renderTargets.getScreenHeight());
 
         glm::mat4 view = camera.getViewMatrix();
         glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
 
-        // Use your main shader for rendering
-        shader.use();
-        shader.setMat4("view", view);
-        shader.setMat4("projection", projection);
-        shader.setVec3("lightPos", lightPos);
-        shader.setVec3("lightColor", lightColor);
-        shader.setVec3("objectColor", objectColor);
-        shader.setBool("useTexture", true);
-
-        // Render models
-        for (const auto& model : models)
+        FrameData frameData;
+        frameData.view = view;
+        frameData.projection = projection;
+        frameData.lightPos = glm::vec4(lightPos, 1.0f);
+        frameData.lightColor = glm::vec4(lightColor, 1.0f);
+        frameData.objectColor = glm::vec4(objectColor, 1.0f);
+        frameData.jitter = glm::vec4(jitter, 0.0f, 0.0f);
+        frameUniforms.update(frameData);
+
+        // Gather every object's transform, then compute and upload them in one go
+        transforms.clear();
+        drawModels.clear();
+        // the copies of every model and the terrain must fit the transform buffer
+        int maxCopies = std::max(((int)transforms.getCapacity() - 1) / std::max((int)models.size(), 1), 1);
+        modelCopies = std::min(std::max(modelCopies, 1), maxCopies);
+        int gridSide = (int)ceil(sqrt((float)modelCopies));
+        float gridSpacing = 3.0f * scale;
+        for (size_t i = 0; i < models.size(); i++)
         {
-            glm::mat4 modelMatrix = glm::mat4(1.0f);
-
-            modelMatrix = glm::translate(modelMatrix, glm::vec3(0.0f, 0.0f, 0.0f));
-            modelMatrix = glm::rotate(modelMatrix, glm::radians(rotationX), glm::vec3(1.0f, 0.0f, 0.0f));
-            modelMatrix = glm::rotate(modelMatrix, glm::radians(rotationY), glm::vec3(0.0f, 1.0f, 0.0f));
-            modelMatrix = glm::rotate(modelMatrix, glm::radians(rotationZ), glm::vec3(0.0f, 0.0f, 1.0f));
-            modelMatrix = glm::scale(modelMatrix, glm::vec3(scale, scale, scale));
-
-            shader.setMat4("model", modelMatrix);
-            model.Draw();
+            const TextureSlot& slot = models[i].getTextureSlot();
+            for (int copy = 0; copy < modelCopies; copy++)
+            {
+                glm::vec3 position = glm::vec3(copy % gridSide, 0.0f, copy / gridSide) * gridSpacing;
+                position -= glm::vec3(gridSide - 1, 0.0f, gridSide - 1) * (gridSpacing * 0.5f);
+                transforms.add(position, glm::vec3(rotationX, rotationY, rotationZ), glm::vec3(scale), slot.uvRect, slot.layer);
+                drawModels.push_back((unsigned int)i);
+            }
+        }
+        int terrainDrawIndex = transforms.add(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(1.0f), terrainSlot.uvRect, terrainSlot.layer);
+        transforms.update(view, projection, jitter);
+        transforms.bind();
+
+        // every copy of a model asks its texture for the mip its footprint on
+        // screen needs; the texture keeps the finest level asked for
+        float projectionScale = sceneHeight / (2.0f * tan(glm::radians(45.0f) * 0.5f));
+        for (size_t i = 0; i < drawModels.size(); i++)
+            models[drawModels[i]].requestTextureLevel(transforms.getWorld((int)i), camera.getPosition(), projectionScale);
+
+        unsigned int terrainFeatures = 0;
+        if (terrainVirtual.isValid())
+            terrainFeatures = MATERIAL_VIRTUAL_TEXTURE;
+        else if (terrainSlot.array)
+            terrainFeatures = MATERIAL_TEXTURE_ARRAY;
+        else if (terrainTexture && terrainTexture->getID())
+            terrainFeatures = MATERIAL_USE_TEXTURE;
+        unsigned int terrainMaterial = terrainSlot.array ? terrainSlot.array->getID() : terrainTexture ? terrainTexture->getID() : 0;
+
+        // Queue the scene's draws by program, material, mesh and distance; the
+        // item index is the draw index into the transform batch
+        const float farPlane = 100.0f;
+        renderQueue.clear();
+        for (size_t i = 0; i < drawModels.size(); i++)
+        {
+            const Model& model = models[drawModels[i]];
+            float depth = glm::distance(camera.getPosition(), glm::vec3(transforms.getWorld((int)i)[3])) / farPlane;
+            renderQueue.push(RenderQueue::makeKey(0, false, litShader.get(model.getMaterialFeatures()).ID,
+                model.getTextureID(), model.getMeshID(), depth), (unsigned int)i);
+        }
+        float terrainDepth = glm::distance(camera.getPosition(), glm::vec3(transforms.getWorld(terrainDrawIndex)[3])) / farPlane;
+        renderQueue.push(RenderQueue::makeKey(0, false, litShader.get(terrainFeatures).ID, terrainMaterial, 0, terrainDepth),
+            (unsigned int)terrainDrawIndex);
+        renderQueue.sort();
+
+        // copies of a model next to each other in the queue become one
+        // instanced draw, their draw indices streamed in queue order
+        renderQueue.buildBatches([&](unsigned int a, unsigned int b) {
+            return a < drawModels.size() && b < drawModels.size() && drawModels[a] == drawModels[b];
+        });
+        instanceIndices.clear();
+        for (const RenderItem& item : renderQueue.getItems())
+            instanceIndices.push_back((int)item.index);
+        instances.upload(instanceIndices);
+
+        // a texture array is only rebound when a draw needs a different one
+        unsigned int boundArray = 0;
+        auto bindTextureSlot = [&](const TextureSlot& slot) {
+            if (slot.array && slot.array->getID() != boundArray)
+            {
+                slot.array->bind(TEXTURE_ARRAY_UNIT);
+                boundArray = slot.array->getID();
+            }
+        };
+
+        // The frame: each pass declares what it reads and writes, the graph
+        // orders them, drops unused ones and provides their targets
+        FrameResource backbuffer = frameGraph.getBackbuffer();
+        RenderTargetDesc sceneDesc;
+        sceneDesc.width = sceneWidth;
+        sceneDesc.height = sceneHeight;
+        sceneDesc.format = GL_RGBA16F;
+        FrameResource sceneColor = frameGraph.createTexture("Scene colour", sceneDesc);
+        sceneDesc.format = GL_DEPTH24_STENCIL8;
+        FrameResource sceneDepth = frameGraph.createTexture("Scene depth", sceneDesc);
+        // motion vectors are only written while TAA needs them
+        FrameResource sceneVelocity = NO_FRAME_RESOURCE;
+        if (taaSettings.enabled)
+        {
+            sceneDesc.format = GL_RG16F;
+            sceneVelocity = frameGraph.createTexture("Scene velocity", sceneDesc);
         }
 
-        // Render terrain
-        terrainTexture.bind(0);
-        shader.setInt("texture1", 0);
-        shader.setMat4("model", glm::mat4(1.0f));
-        terrain.draw();
+        // Virtual texture feedback: the terrain at low resolution, read back a
+        // few frames later to decide which pages to stream in
+        frameGraph.addPass("Virtual texture feedback",
+            [&](FrameGraph::Builder& pass) {
+                pass.setSideEffect();
+            },
+            [&]() {
+                if (!terrainVirtual.beginFeedback(sceneWidth, sceneHeight))
+                    return;
+                feedbackShader.use();
+                terrainVirtual.setUniforms(feedbackShader, true);
+                feedbackShader.setInt("transforms"_u, TRANSFORM_TEXTURE_UNIT);
+                feedbackShader.setInt("drawIndex"_u, terrainDrawIndex);
+                terrain.draw();
+                terrainVirtual.endFeedback();
+            });
+
+        frameGraph.addPass("Scene",
+            [&](FrameGraph::Builder& pass) {
+                pass.writeColor(sceneColor, true, glm::vec4(0.2f, 0.3f, 0.3f, 1.0f));
+                if (sceneVelocity != NO_FRAME_RESOURCE)
+                    pass.writeColor(sceneVelocity, true);
+                pass.writeDepth(sceneDepth, true);
+            },
+            [&]() {
+                GLState::enable(GL_DEPTH_TEST);
+                bool blending = false;
+                const std::vector<RenderItem>& items = renderQueue.getItems();
+                for (const RenderBatch& batch : renderQueue.getBatches())
+                {
+                    const RenderItem& item = items[batch.first];
+                    // translucent items sort last and blend over the opaque ones
+                    if (RenderQueue::isTranslucent(batch.key) && !blending)
+                    {
+                        GLState::enable(GL_BLEND);
+                        GLState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+                        GLState::depthMask(GL_FALSE);
+                        blending = true;
+                    }
+
+                    if (item.index == (unsigned int)terrainDrawIndex)
+                    {
+                        Shader& terrainShader = litShader.get(terrainFeatures);
+                        terrainShader.use();
+                        if (terrainTexture)
+                            terrainTexture->bind(0);
+                        bindTextureSlot(terrainSlot);
+                        terrainShader.setInt("texture1"_u, 0);
+                        terrainShader.setInt("textureArray"_u, TEXTURE_ARRAY_UNIT);
+                        if (terrainVirtual.isValid())
+                        {
+                            terrainVirtual.bind();
+                            terrainVirtual.setUniforms(terrainShader, false);
+                        }
+                        terrainShader.setInt("transforms"_u, TRANSFORM_TEXTURE_UNIT);
+                        terrainShader.setInt("drawIndex"_u, terrainDrawIndex);
+                        terrain.draw();
+                        continue;
+                    }
+
+                    // each instance's draw index comes from the instance buffer
+                    const Model& model = models[drawModels[item.index]];
+                    Shader& modelShader = litShader.get(model.getMaterialFeatures());
+                    modelShader.use();
+                    bindTextureSlot(model.getTextureSlot());
+                    modelShader.setInt("textureArray"_u, TEXTURE_ARRAY_UNIT);
+                    modelShader.setInt("transforms"_u, TRANSFORM_TEXTURE_UNIT);
+                    modelShader.setInt("drawIndex"_u, 0);
+                    model.Draw(instances, batch.first, batch.count);
+                }
+                if (blending)
+                {
+                    GLState::disable(GL_BLEND);
+                    GLState::depthMask(GL_TRUE);
+                }
+            });
+
+        // Post processing: resolve TAA into window resolution, threshold and
+        // downsample the scene through the bloom chain and add it back up, then
+        // composite, tone map, gamma correct and grade in one full-screen pass
+        // into the window. The exposure is measured from the scene on the GPU
+        // and stays there.
+        PostInputs postInputs;
+        postInputs.scene = sceneColor;
+        if (sceneVelocity != NO_FRAME_RESOURCE)
+        {
+            postInputs.scene = temporalAA.addPass(frameGraph, sceneColor, sceneVelocity, sceneDepth, taaSettings);
+            postInputs.temporal = postInputs.scene != sceneColor;
+        }
+        if (postSettings.bloomStrength > 0.0f)
+        {
+            postInputs.bloom = bloom.addPasses(frameGraph, sceneColor, bloomSettings);
+            postInputs.bloomScale = bloom.getCompositeScale();
+        }
+        postInputs.exposure = autoExposure.addPass(frameGraph, sceneColor, exposureSettings, deltaTime);
+        postProcess.addPass(frameGraph, postInputs, backbuffer, postSettings);
+        frameGraph.execute();
 
         if (autoRotate) {
 
@@ -260,14 +553,14 @@ int main()
 
         // Apply wireframe mode if enabled
         if (wireframeModePoints) {
-            glPolygonMode(GL_FRONT_AND_BACK, GL_POINT);
+            GLState::polygonMode(GL_FRONT_AND_BACK, GL_POINT);
             glPointSize(pointSize);
         }
         else if (wireframeMode) {
-            glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+            GLState::polygonMode(GL_FRONT_AND_BACK, GL_LINE);
         }
         else {
-            glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);   
+            GLState::polygonMode(GL_FRONT_AND_BACK, GL_FILL);   
         }
 
         ImGui_ImplOpenGL3_NewFrame();
@@ -280,6 +573,7 @@ int main()
         ImGui::Checkbox("Draw Model", &drawModel);
         ImGui::ColorEdit4("Color", color);
         ImGui::SliderFloat("size", &scale, 0.1f, 3.0f);
+        ImGui::SliderInt("Copies", &modelCopies, 1, std::min(10000, maxCopies), "%d", ImGuiSliderFlags_Logarithmic);
         ImGui::Checkbox("Wireframe", &wireframeMode);
         ImGui::Checkbox("Wireframe_Points", &wireframeModePoints);
         ImGui::SliderFloat("Point_Size", &pointSize, 0.0f, 100.0f);
@@ -288,17 +582,178 @@ int main()
         ImGui::SliderFloat("Rotation Z", &rotationZ, 0.0f, 360.0f); // Rotation around Z
         ImGui::Checkbox("autoRotate", &autoRotate);
         ImGui::Checkbox("colorCycle", &colorCycle);
+        ImGui::Text("Uniform location queries: %u", uniformQueries);
+        ImGui::Text("Lit shader variants: %zu / %zu", litShader.getVariantCount(), litShader.getMaxVariantCount());
+        ImGui::Text("Textures loading: %zu (%.1f KB uploaded last frame%s)", textureLoader.getPendingCount(),
+            textureLoader.getUploadedLastFrame() / 1024.0, textureLoader.isPersistentlyMapped() ? ", persistent PBO" : "");
         ImGui::End();
 
         ImGui::Begin("Terrain");
         ImGui::SliderFloat("Size", &terrainSize, 10.0f, 300.0f);
+        bool samplingChanged = ImGui::Checkbox("Trilinear", &trilinearFiltering);
+        samplingChanged |= ImGui::SliderFloat("Anisotropy", &anisotropy, 1.0f, 16.0f);
+        if (samplingChanged)
+        {
+            if (terrainTexture)
+                terrainTexture->setSampling(trilinearFiltering, anisotropy);
+            texturePack.setSampling(trilinearFiltering, anisotropy);
+        }
+        if (terrainTexture)
+        {
+            ImGui::Text("Grass mip levels: %d", terrainTexture->getMipCount());
+            ImGui::Text("Grass memory: %.2f MB (%s)", terrainTexture->getMemoryUsage() / (1024.0 * 1024.0),
+                terrainTexture->isCompressed() ? "block compressed" : "RGBA8");
+        }
+        else if (terrainSlot.array)
+        {
+            ImGui::Text("Grass: layer %d of a %dx%d array, %d mip levels", terrainSlot.layer,
+                terrainSlot.array->getWidth(), terrainSlot.array->getHeight(), terrainSlot.array->getMipCount());
+        }
+        ImGui::End();
+
+        ImGui::Begin("Textures");
+        static int textureBudgetMB = 256;
+        if (ImGui::SliderInt("Budget (MB)", &textureBudgetMB, 1, 1024))
+            textureManager.setBudget((size_t)textureBudgetMB * 1024 * 1024);
+        ImGui::Text("Resident: %.2f MB", textureManager.getResidentBytes() / (1024.0 * 1024.0));
+        ImGui::Text("Packed: %zu textures in %zu arrays, %.2f MB", texturePack.getTextureCount(),
+            texturePack.getArrayCount(), texturePack.getMemoryUsage() / (1024.0 * 1024.0));
+        if (terrainVirtual.isValid())
+        {
+            const VirtualTextureLayout& layout = terrainVirtual.getLayout();
+            ImGui::Text("Virtual: %dx%d, %d/%d pages resident (%.2f MB)", layout.virtualSize(), layout.virtualSize(),
+                terrainVirtual.getResidentPages(), terrainVirtual.getCachePages(), terrainVirtual.getMemoryUsage() / (1024.0 * 1024.0));
+            ImGui::Text("Virtual: %d pages needed, %zu loading, %d uploaded", terrainVirtual.getRequestedLastFeedback(),
+                terrainVirtual.getPendingPages(), terrainVirtual.getUploadedLastFrame());
+        }
+        if (ImGui::BeginTable("Residency", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+        {
+            ImGui::TableSetupColumn("Texture");
+            ImGui::TableSetupColumn("KB");
+            ImGui::TableSetupColumn("Mips");
+            ImGui::TableSetupColumn("Users");
+            ImGui::TableSetupColumn("Idle");
+            ImGui::TableHeadersRow();
+            for (const TextureResidency& entry : textureManager.getResidency())
+            {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(entry.path.c_str());
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f%s", entry.residentBytes / 1024.0, entry.ready ? "" : " (loading)");
+                ImGui::TableNextColumn();
+                ImGui::Text("%d-%d (want %d)", entry.baseLevel, entry.mipCount - 1, entry.wantedLevel);
+                ImGui::TableNextColumn();
+                ImGui::Text("%ld", entry.users);
+                ImGui::TableNextColumn();
+                ImGui::Text("%u", entry.idleFrames);
+            }
+            ImGui::EndTable();
+        }
         ImGui::End();
 
         ImGui::Begin("Bloom Debug");
-        static float bloomThreshold = 1.0f;
-        static float bloomIntensity = 1.0f;
-        ImGui::SliderFloat("Bloom Threshold", &bloomThreshold, 0.0f, 5.0f);
-        ImGui::SliderFloat("Bloom Intensity", &bloomIntensity, 0.0f, 2.0f);
+        ImGui::SliderFloat("Bloom Threshold", &bloomSettings.threshold, 0.0f, 5.0f);
+        ImGui::SliderFloat("Bloom Intensity", &postSettings.bloomStrength, 0.0f, 2.0f);
+        ImGui::SliderFloat("Bloom Radius", &bloomSettings.filterRadius, 0.5f, 3.0f);
+        ImGui::Text("Chain: %d levels below %dx%d", bloom.getMipCount(),
+            dynamicResolution.scaled(framebufferWidth), dynamicResolution.scaled(framebufferHeight));
+        ImGui::SliderInt("Blur Radius", &bloomSettings.blurRadius, 0, BloomEffect::MAX_BLUR_RADIUS);
+        if (bloom.isComputeBlurAvailable())
+        {
+            bool computeBlur = bloom.isComputeBlur();
+            if (ImGui::Checkbox("Compute Blur", &computeBlur))
+                bloom.setComputeBlur(computeBlur);
+        }
+        else
+        {
+            ImGui::TextDisabled("Compute Blur: needs GL 4.3");
+        }
+        ImGui::Text("Render targets: %d, %.1f MB allocated, %.1f MB saved by reuse",
+            renderTargets.getTargetCount(), renderTargets.getAllocatedBytes() / (1024.0 * 1024.0),
+            renderTargets.getSavedBytes() / (1024.0 * 1024.0));
+        // both blur paths keep their last timing, so toggling compares them
+        double computeBlurMs = frameGraph.getPassMilliseconds("Bloom blur (compute)");
+        double fragmentBlurMs = frameGraph.getPassMilliseconds("Bloom blur horizontal") + frameGraph.getPassMilliseconds("Bloom blur vertical");
+        if (computeBlurMs >= 0.0)
+            ImGui::Text("Blur (compute):  %.3f ms", computeBlurMs);
+        if (fragmentBlurMs >= 0.0)
+            ImGui::Text("Blur (fragment): %.3f ms", fragmentBlurMs);
+        ImGui::End();
+
+        ImGui::Begin("Post Processing");
+        ImGui::Checkbox("Tone Mapping", &postSettings.tonemap);
+        ImGui::SliderFloat("Exposure", &postSettings.exposure, 0.1f, 5.0f);
+        if (autoExposure.isAvailable())
+        {
+            ImGui::Checkbox("Auto Exposure", &exposureSettings.enabled);
+            ImGui::SliderFloat("Key", &exposureSettings.key, 0.05f, 1.0f);
+            ImGui::SliderFloat("Adaptation Speed", &exposureSettings.adaptationSpeed, 0.1f, 10.0f);
+            ImGui::DragFloatRange2("Log Luminance", &exposureSettings.minLogLuminance, &exposureSettings.maxLogLuminance, 0.1f, -16.0f, 16.0f);
+            double exposureMs = frameGraph.getPassMilliseconds("Auto exposure");
+            if (exposureMs >= 0.0)
+                ImGui::Text("Auto exposure: %.3f ms", exposureMs);
+        }
+        else
+        {
+            ImGui::TextDisabled("Auto Exposure: needs GL 4.3");
+        }
+        ImGui::Checkbox("Gamma Correction", &postSettings.gammaCorrect);
+        ImGui::SliderFloat("Gamma", &postSettings.gamma, 1.0f, 3.0f);
+        ImGui::Checkbox("Color Grading", &postSettings.colorGrading);
+        ImGui::SliderFloat("Grading Amount", &postSettings.gradingAmount, 0.0f, 1.0f);
+        if (postProcess.isLutLoaded())
+        {
+            ImGui::Text("LUT: %s (%d^3)", postProcess.getLutPath().c_str(), postProcess.getLutSize());
+        }
+        else
+        {
+            ImGui::SliderFloat("Saturation", &postSettings.saturation, 0.0f, 2.0f);
+            ImGui::SliderFloat("Contrast", &postSettings.contrast, 0.5f, 1.5f);
+            ImGui::SliderFloat("Temperature", &postSettings.temperature, -1.0f, 1.0f);
+        }
+        ImGui::Text("Variant 0x%x, %zu compiled", postProcess.getFeatures(), postProcess.getVariantCount());
+        double postMs = frameGraph.getPassMilliseconds("Post");
+        if (postMs >= 0.0)
+            ImGui::Text("Post pass: %.3f ms", postMs);
+        ImGui::End();
+
+        ImGui::Begin("Temporal AA");
+        ImGui::Checkbox("Enabled", &taaSettings.enabled);
+        ImGui::SliderFloat("Blend", &taaSettings.blend, 0.02f, 0.5f);
+        ImGui::SliderFloat("Clip Gamma", &taaSettings.clipGamma, 0.5f, 2.0f);
+        if (taaSettings.enabled)
+        {
+            glm::vec2 jitterPixels = temporalAA.getJitterPixels();
+            ImGui::Text("Jitter: %d phases, now (%+.2f, %+.2f) px", temporalAA.getJitterPhases(), jitterPixels.x, jitterPixels.y);
+        }
+        double taaMs = frameGraph.getPassMilliseconds("TAA resolve");
+        if (taaMs >= 0.0)
+            ImGui::Text("Resolve: %.3f ms", taaMs);
+        ImGui::End();
+
+        ImGui::Begin("Dynamic Resolution");
+        ImGui::Checkbox("Enabled", &resolutionSettings.enabled);
+        ImGui::SliderFloat("Target GPU ms", &resolutionSettings.targetMilliseconds, 4.0f, 33.0f);
+        ImGui::SliderFloat("Min Scale", &resolutionSettings.minScale, 0.25f, 1.0f);
+        ImGui::SliderFloat("Max Scale", &resolutionSettings.maxScale, 0.25f, 1.0f);
+        ImGui::SliderFloat("Sharpness", &postSettings.sharpness, 0.0f, 1.0f);
+        ImGui::Text("Scene %dx%d (%.0f%%) of %dx%d", dynamicResolution.scaled(framebufferWidth), dynamicResolution.scaled(framebufferHeight),
+            dynamicResolution.getScale() * 100.0f, framebufferWidth, framebufferHeight);
+        ImGui::Text("GPU frame: %.3f ms, %d scale changes", frameGraph.getGpuMilliseconds(), dynamicResolution.getScaleChanges());
+        ImGui::End();
+
+        ImGui::Begin("Frame Graph");
+        ImGui::TextUnformatted(frameGraph.dump().c_str());
+        ImGui::Text("Render queue: %zu items in %zu draws, %d radix passes", renderQueue.getItems().size(),
+            renderQueue.getBatches().size(), renderQueue.getSortPasses());
+        if (ImGui::CollapsingHeader("GL state changes"))
+        {
+            const GLState::Counters& stateCounters = GLState::getLastFrameCounters();
+            for (int call = 0; call < GLState::CALL_KINDS; call++)
+                ImGui::Text("%-15s %5u issued %5u skipped", GLState::getCallName((GLState::Call)call),
+                    stateCounters.issued[call], stateCounters.skipped[call]);
+        }
         ImGui::End();
 
         if (terrainSize) {
@@ -309,6 +764,8 @@ int main()
         ImGui::Render();
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 
+        frameUniforms.endFrame();
+
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
         // -------------------------------------------------------------------------------
         glfwSwapBuffers(window);
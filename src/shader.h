@@ -1,26 +1,129 @@
 #pragma once
 #include <glad/glad.h>
 #include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <glm/glm.hpp>
 
+// FNV-1a hash of a uniform name, usable at compile time
+constexpr uint32_t hashUniformName(std::string_view name)
+{
+    uint32_t hash = 2166136261u;
+    for (char c : name)
+    {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Pre-hashed uniform name, e.g. shader.setMat4("model"_u, m)
+struct UniformId
+{
+    uint32_t hash;
+};
+
+constexpr UniformId operator""_u(const char* str, std::size_t len)
+{
+    return UniformId{ hashUniformName(std::string_view(str, len)) };
+}
+
 class Shader
 {
 public:
     unsigned int ID;
 
-    Shader(const char* vertexPath, const char* fragmentPath);
+    // defines are injected as "#define KEY" lines after #version in both stages
+    Shader(const char* vertexPath, const char* fragmentPath, const std::vector<std::string>& defines = {});
+    // compute program; only build one when GLExt::hasComputeShader
+    explicit Shader(const char* computePath, const std::vector<std::string>& defines = {});
+    ~Shader();
+
+    Shader(const Shader&) = delete;
+    Shader& operator=(const Shader&) = delete;
 
     void use();
 
-    void setBool(const std::string& name, bool value) const;
-    void setInt(const std::string& name, int value) const;
-    void setFloat(const std::string& name, float value) const;
-    void setVec3(const std::string& name, const glm::vec3& value) const;
-    void setMat4(const std::string& name, const glm::mat4& mat) const;
+    // While a batch is open, new Shaders only submit their compile and link;
+    // endBatch() then waits on all of them, so the driver can build them in parallel
+    static void beginBatch();
+    static void endBatch();
+
+    // Hot reload: beginReload() recompiles from disk without blocking,
+    // pollReload() swaps the new program in once it has linked successfully
+    // and returns true when it did (cached locations must then be refreshed).
+    // Only with KHR_parallel_shader_compile is this free of stalls; without
+    // it pollReload() waits a frame and then blocks on the link once.
+    bool usesFile(const std::string& path) const;
+    void beginReload();
+    bool pollReload();
+
+    // Location lookups go through the table built after linking; only names
+    // missing from it (e.g. individual array elements) reach the driver
+    int getUniformLocation(std::string_view name) const;
+    int getUniformLocation(UniformId id) const;
+
+    void setBool(int location, bool value) const;
+    void setInt(int location, int value) const;
+    void setFloat(int location, float value) const;
+    void setVec2(int location, const glm::vec2& value) const;
+    void setVec3(int location, const glm::vec3& value) const;
+    void setVec4(int location, const glm::vec4& value) const;
+    void setMat4(int location, const glm::mat4& mat) const;
+    void setFloatArray(int location, const float* values, int count) const;
+
+    void setBool(std::string_view name, bool value) const { setBool(getUniformLocation(name), value); }
+    void setInt(std::string_view name, int value) const { setInt(getUniformLocation(name), value); }
+    void setFloat(std::string_view name, float value) const { setFloat(getUniformLocation(name), value); }
+    void setVec2(std::string_view name, const glm::vec2& value) const { setVec2(getUniformLocation(name), value); }
+    void setVec3(std::string_view name, const glm::vec3& value) const { setVec3(getUniformLocation(name), value); }
+    void setVec4(std::string_view name, const glm::vec4& value) const { setVec4(getUniformLocation(name), value); }
+    void setMat4(std::string_view name, const glm::mat4& mat) const { setMat4(getUniformLocation(name), mat); }
+    void setFloatArray(std::string_view name, const float* values, int count) const { setFloatArray(getUniformLocation(name), values, count); }
+
+    void setBool(UniformId id, bool value) const { setBool(getUniformLocation(id), value); }
+    void setInt(UniformId id, int value) const { setInt(getUniformLocation(id), value); }
+    void setFloat(UniformId id, float value) const { setFloat(getUniformLocation(id), value); }
+    void setVec2(UniformId id, const glm::vec2& value) const { setVec2(getUniformLocation(id), value); }
+    void setVec3(UniformId id, const glm::vec3& value) const { setVec3(getUniformLocation(id), value); }
+    void setVec4(UniformId id, const glm::vec4& value) const { setVec4(getUniformLocation(id), value); }
+    void setMat4(UniformId id, const glm::mat4& mat) const { setMat4(getUniformLocation(id), mat); }
+    void setFloatArray(UniformId id, const float* values, int count) const { setFloatArray(getUniformLocation(id), values, count); }
+
+    // Number of glGetUniformLocation calls issued since the last reset
+    static unsigned int getLocationQueryCount() { return s_locationQueries; }
+    static void resetLocationQueryCount() { s_locationQueries = 0; }
 
 private:
-    void checkCompileErrors(unsigned int shader, std::string type);
-};
\ No newline at end of file
+    struct UniformEntry
+    {
+        uint32_t hash;
+        int location;
+        std::string name;
+    };
+
+    std::string m_VertexPath;
+    std::string m_FragmentPath;
+    std::string m_ComputePath;
+    std::vector<std::string> m_Defines;
+    unsigned int m_PendingID;
+    int m_PendingPolls;
+
+    mutable std::vector<UniformEntry> m_uniforms;
+    static unsigned int s_locationQueries;
+    static int s_BatchDepth;
+    static std::vector<Shader*> s_Batch;
+
+    void build();
+    void finishBuild();
+    // reads the stage files and acquires their program; 0 if requireFiles and one is unreadable
+    unsigned int submitProgram(bool requireFiles) const;
+    std::string describe() const;
+    void cancelReload();
+    void buildUniformTable();
+    void bindUniformBlocks();
+};
@@ -0,0 +1,229 @@
+#include "TexturePacker.h"
+#include "stb_image.h"
+#include "MipGenerator.h"
+#include "TextureContainer.h"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <utility>
+
+namespace {
+    struct SourceImage {
+        std::string path;
+        int width, height;
+        std::vector<unsigned char> pixels;
+    };
+
+    // Textures sharing one array: every layer has the same size and mip count
+    struct Group {
+        std::string file;
+        int width, height;
+        std::vector<std::vector<MipLevel>> layers;
+    };
+
+    struct Record {
+        size_t source;
+        size_t group;
+        int layer;
+        int x, y; // texel offset inside the layer
+    };
+
+    int alignUp(int value, int alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    int wrap(int value, int size)
+    {
+        value %= size;
+        return value < 0 ? value + size : value;
+    }
+
+    // Copies image into the cell at (cellX, cellY) of page with its top-left
+    // texel at (cellX + gutter, cellY + gutter), filling the rest of the cell
+    // by wrapping so filtering across the edges matches GL_REPEAT
+    void blitWrapped(std::vector<unsigned char>& page, int pageSize, const SourceImage& image,
+        int cellX, int cellY, int cellWidth, int cellHeight, int gutter)
+    {
+        for (int y = 0; y < cellHeight; y++)
+        {
+            int sourceY = wrap(y - gutter, image.height);
+            for (int x = 0; x < cellWidth; x++)
+            {
+                int sourceX = wrap(x - gutter, image.width);
+                const unsigned char* from = &image.pixels[((size_t)sourceY * image.width + sourceX) * 4];
+                unsigned char* to = &page[((size_t)(cellY + y) * pageSize + cellX + x) * 4];
+                std::copy(from, from + 4, to);
+            }
+        }
+    }
+}
+
+bool packTextures(const std::vector<std::string>& inputs, const std::string& manifestPath, const PackSettings& settings)
+{
+    // Texture flips on load, so the packed rows must be stored the same way
+    stbi_set_flip_vertically_on_load(1);
+    std::vector<SourceImage> sources;
+    for (const std::string& input : inputs)
+    {
+        int width = 0, height = 0, channels = 0;
+        unsigned char* pixels = stbi_load(input.c_str(), &width, &height, &channels, 4);
+        if (!pixels)
+        {
+            std::cout << "Failed to load " << input << std::endl;
+            return false;
+        }
+        sources.push_back({ input, width, height, std::vector<unsigned char>(pixels, pixels + (size_t)width * height * 4) });
+        stbi_image_free(pixels);
+    }
+
+    std::filesystem::path manifest(manifestPath);
+    std::string stem = manifest.stem().string();
+    std::vector<Group> groups;
+    std::vector<Record> records;
+
+    // Large textures: one layer each, in an array per distinct size
+    std::map<std::pair<int, int>, size_t> groupBySize;
+    std::vector<size_t> atlased;
+    for (size_t i = 0; i < sources.size(); i++)
+    {
+        const SourceImage& source = sources[i];
+        if (source.width <= settings.maxAtlasedSize && source.height <= settings.maxAtlasedSize)
+        {
+            atlased.push_back(i);
+            continue;
+        }
+
+        auto key = std::make_pair(source.width, source.height);
+        auto it = groupBySize.find(key);
+        if (it == groupBySize.end())
+        {
+            std::string file = stem + "_" + std::to_string(source.width) + "x" + std::to_string(source.height) + ".bct";
+            it = groupBySize.emplace(key, groups.size()).first;
+            groups.push_back({ file, source.width, source.height, {} });
+        }
+        Group& group = groups[it->second];
+        records.push_back({ i, it->second, (int)group.layers.size(), 0, 0 });
+        group.layers.push_back(generateMipChain(source.pixels.data(), source.width, source.height, MipFilter::Kaiser));
+    }
+
+    // Small textures: shelf-packed into atlas pages, tallest first. Only the
+    // levels where the gutter is still at least a texel wide are kept, and
+    // cells are aligned so every kept level starts on a texel boundary.
+    if (!atlased.empty())
+    {
+        int atlasLevels = 1;
+        while ((settings.gutter >> atlasLevels) > 0)
+            atlasLevels++;
+        int cellAlignment = std::max(4, 1 << (atlasLevels - 1));
+        int size = settings.atlasSize;
+
+        std::stable_sort(atlased.begin(), atlased.end(), [&](size_t a, size_t b) {
+            return sources[a].height > sources[b].height;
+        });
+
+        size_t groupIndex = groups.size();
+        groups.push_back({ stem + "_atlas.bct", size, size, {} });
+        std::vector<std::vector<unsigned char>> pages;
+        int x = 0, y = 0, shelfHeight = 0;
+        for (size_t i : atlased)
+        {
+            const SourceImage& source = sources[i];
+            int cellWidth = alignUp(source.width + 2 * settings.gutter, cellAlignment);
+            int cellHeight = alignUp(source.height + 2 * settings.gutter, cellAlignment);
+            if (cellWidth > size || cellHeight > size)
+            {
+                std::cout << source.path << " does not fit in a " << size << "x" << size << " atlas page" << std::endl;
+                return false;
+            }
+
+            if (!pages.empty() && x + cellWidth > size)
+            {
+                x = 0;
+                y += shelfHeight;
+                shelfHeight = 0;
+            }
+            if (pages.empty() || y + cellHeight > size)
+            {
+                pages.emplace_back((size_t)size * size * 4, 0);
+                x = y = shelfHeight = 0;
+            }
+
+            blitWrapped(pages.back(), size, source, x, y, cellWidth, cellHeight, settings.gutter);
+            records.push_back({ i, groupIndex, (int)pages.size() - 1, x + settings.gutter, y + settings.gutter });
+            x += cellWidth;
+            shelfHeight = std::max(shelfHeight, cellHeight);
+        }
+
+        for (const std::vector<unsigned char>& page : pages)
+        {
+            std::vector<MipLevel> chain = generateMipChain(page.data(), size, size, MipFilter::Kaiser);
+            if ((int)chain.size() > atlasLevels)
+                chain.resize(atlasLevels);
+            groups[groupIndex].layers.push_back(std::move(chain));
+        }
+    }
+
+    // Encode each level of every layer; a level holds all layers back to back
+    std::filesystem::path directory = manifest.parent_path();
+    for (const Group& group : groups)
+    {
+        CompressedImage image;
+        image.format = settings.format;
+        image.glInternalFormat = glInternalFormat(settings.format);
+        image.width = group.width;
+        image.height = group.height;
+        image.layers = (int)group.layers.size();
+
+        size_t levelCount = group.layers[0].size();
+        for (size_t level = 0; level < levelCount; level++)
+        {
+            const MipLevel& first = group.layers[0][level];
+            CompressedLevel compressed = { first.width, first.height, {} };
+            for (const std::vector<MipLevel>& layer : group.layers)
+            {
+                const MipLevel& mip = layer[level];
+                std::vector<uint8_t> blocks = encodeBlocks(mip.pixels.data(), mip.width, mip.height,
+                    settings.format, settings.preset, settings.threads);
+                compressed.data.insert(compressed.data.end(), blocks.begin(), blocks.end());
+            }
+            image.levels.push_back(std::move(compressed));
+        }
+
+        std::string path = (directory / group.file).string();
+        if (!writeTextureContainer(path, image))
+        {
+            std::cout << "Failed to write " << path << std::endl;
+            return false;
+        }
+        size_t bytes = 0;
+        for (const CompressedLevel& level : image.levels)
+            bytes += level.data.size();
+        printf("  %s: %d layers of %dx%d, %zu levels, %.1f KB\n", group.file.c_str(), image.layers,
+            group.width, group.height, levelCount, bytes / 1024.0);
+    }
+
+    std::ofstream file(manifestPath, std::ios::trunc);
+    if (!file)
+    {
+        std::cout << "Failed to write " << manifestPath << std::endl;
+        return false;
+    }
+    file.precision(9);
+    file << "# written by TextureCooker --pack\n";
+    for (const Group& group : groups)
+        file << "array " << group.file << "\n";
+    for (const Record& record : records)
+    {
+        const SourceImage& source = sources[record.source];
+        const Group& group = groups[record.group];
+        file << "texture " << std::filesystem::path(source.path).generic_string() << " " << record.group << " " << record.layer << " "
+            << (double)record.x / group.width << " " << (double)record.y / group.height << " "
+            << (double)source.width / group.width << " " << (double)source.height / group.height << "\n";
+    }
+    printf("  %zu textures in %zu arrays -> %s\n", sources.size(), groups.size(), manifestPath.c_str());
+    return (bool)file;
+}
@@ -0,0 +1,26 @@
+#ifndef TEXTURE_PACKER_H
+#define TEXTURE_PACKER_H
+
+#include <string>
+#include <vector>
+#include "TextureEncoder.h"
+
+struct PackSettings {
+    BlockFormat format = BlockFormat::BC7;
+    EncodePreset preset = EncodePreset::Quality;
+    int threads = 0;
+    // Textures no larger than this on either side are atlased, bigger ones
+    // get whole layers of an array shared with textures of the same size
+    int maxAtlasedSize = 256;
+    int atlasSize = 1024;
+    // Texels of wrapped border around each atlased texture. Atlas mips stop
+    // once the gutter is down to one texel, so neighbours never bleed in.
+    int gutter = 16;
+};
+
+// Packs the inputs into layered .bct files written next to manifestPath,
+// named "<manifest stem>_<width>x<height>.bct" and "<manifest stem>_atlas.bct",
+// and writes the manifest TexturePack reads. Inputs are recorded as given.
+bool packTextures(const std::vector<std::string>& inputs, const std::string& manifestPath, const PackSettings& settings);
+
+#endif // TEXTURE_PACKER_H
@@ -0,0 +1,157 @@
+#include "VirtualTextureBaker.h"
+#include "stb_image.h"
+#include "MipGenerator.h"
+#include "VirtualTextureFile.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <thread>
+
+namespace {
+    // Copies the page at (pageX, pageY) with its border out of level, clamping
+    // at the edges of the virtual texture
+    std::vector<unsigned char> extractPage(const MipLevel& level, int pageX, int pageY, int tileSize, int border)
+    {
+        int padded = tileSize + 2 * border;
+        std::vector<unsigned char> page((size_t)padded * padded * 4);
+        for (int y = 0; y < padded; y++)
+        {
+            int sourceY = std::min(std::max(pageY * tileSize + y - border, 0), level.height - 1);
+            for (int x = 0; x < padded; x++)
+            {
+                int sourceX = std::min(std::max(pageX * tileSize + x - border, 0), level.width - 1);
+                const unsigned char* from = &level.pixels[((size_t)sourceY * level.width + sourceX) * 4];
+                std::copy(from, from + 4, &page[((size_t)y * padded + x) * 4]);
+            }
+        }
+        return page;
+    }
+
+    bool isPowerOfTwo(int value)
+    {
+        return value > 0 && (value & (value - 1)) == 0;
+    }
+}
+
+bool bakeVirtualTexture(const std::vector<std::string>& inputs, const std::string& output, const VirtualBakeSettings& settings)
+{
+    int columns = std::max(settings.gridColumns, 1);
+    int rows = ((int)inputs.size() + columns - 1) / columns;
+    if ((int)inputs.size() != columns * rows)
+    {
+        std::cout << inputs.size() << " inputs do not fill a grid " << columns << " wide" << std::endl;
+        return false;
+    }
+
+    // Texture flips on load, so rows are stored bottom up and the first grid
+    // row ends up at the end of the assembled image
+    stbi_set_flip_vertically_on_load(1);
+    std::vector<unsigned char> pixels;
+    int cellWidth = 0, cellHeight = 0, size = 0;
+    for (int i = 0; i < (int)inputs.size(); i++)
+    {
+        int width = 0, height = 0, channels = 0;
+        unsigned char* cell = stbi_load(inputs[i].c_str(), &width, &height, &channels, 4);
+        if (!cell)
+        {
+            std::cout << "Failed to load " << inputs[i] << std::endl;
+            return false;
+        }
+        if (i == 0)
+        {
+            cellWidth = width;
+            cellHeight = height;
+            size = cellWidth * columns;
+            if (cellHeight * rows != size)
+            {
+                std::cout << "The grid is " << size << "x" << cellHeight * rows << "; virtual textures must be square" << std::endl;
+                stbi_image_free(cell);
+                return false;
+            }
+            pixels.resize((size_t)size * size * 4);
+        }
+        else if (width != cellWidth || height != cellHeight)
+        {
+            std::cout << inputs[i] << " is " << width << "x" << height << ", expected " << cellWidth << "x" << cellHeight << std::endl;
+            stbi_image_free(cell);
+            return false;
+        }
+
+        int left = (i % columns) * cellWidth;
+        int bottom = (rows - 1 - i / columns) * cellHeight;
+        for (int y = 0; y < cellHeight; y++)
+            std::copy(cell + (size_t)y * cellWidth * 4, cell + (size_t)(y + 1) * cellWidth * 4,
+                &pixels[((size_t)(bottom + y) * size + left) * 4]);
+        stbi_image_free(cell);
+    }
+
+    VirtualTextureLayout layout;
+    layout.format = settings.format;
+    layout.glInternalFormat = glInternalFormat(settings.format);
+    layout.tileSize = settings.tileSize;
+    layout.border = settings.border;
+    layout.pagesPerSide = size / settings.tileSize;
+    if (settings.tileSize % 4 != 0 || settings.border % 2 != 0 || size % settings.tileSize != 0 ||
+        !isPowerOfTwo(layout.pagesPerSide) || layout.pagesPerSide > 256)
+    {
+        std::cout << "A " << size << "x" << size << " image does not split into a power of two (at most 256) pages of "
+            << settings.tileSize << " per side" << std::endl;
+        return false;
+    }
+    layout.mipCount = 1;
+    while (layout.pagesAtMip(layout.mipCount - 1) > 1)
+        layout.mipCount++;
+
+    std::vector<MipLevel> chain = generateMipChain(pixels.data(), size, size, MipFilter::Kaiser);
+    chain.resize(layout.mipCount);
+    std::vector<unsigned char>().swap(pixels);
+
+    std::cout << inputs.size() << " image(s) -> " << output << " (" << size << "x" << size << ", "
+        << layout.pagesPerSide << "x" << layout.pagesPerSide << " pages of " << layout.tileSize << ", "
+        << blockFormatName(settings.format) << ")" << std::endl;
+
+    // Pages are small, so a level is encoded page by page across all threads
+    // and held until the writer has consumed it
+    int threads = settings.threads > 0 ? settings.threads : std::max(1u, std::thread::hardware_concurrency());
+    int encodedMip = -1;
+    std::vector<std::vector<uint8_t>> tiles;
+    auto encodeLevel = [&](int mip) {
+        auto start = std::chrono::high_resolution_clock::now();
+        int pages = layout.pagesAtMip(mip);
+        tiles.assign((size_t)pages * pages, {});
+        std::atomic<int> next(0);
+        auto work = [&]() {
+            for (int page = next++; page < pages * pages; page = next++)
+            {
+                std::vector<unsigned char> padded = extractPage(chain[mip], page % pages, page / pages, layout.tileSize, layout.border);
+                tiles[page] = encodeBlocks(padded.data(), layout.paddedTileSize(), layout.paddedTileSize(),
+                    settings.format, settings.preset, 1);
+            }
+        };
+        std::vector<std::thread> pool;
+        for (int t = 1; t < threads; t++)
+            pool.emplace_back(work);
+        work();
+        for (std::thread& thread : pool)
+            thread.join();
+
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        printf("  mip %d  %5dx%-5d  %6d pages  %8.2f ms\n", mip, chain[mip].width, chain[mip].height, pages * pages, ms);
+        encodedMip = mip;
+    };
+
+    bool written = writeVirtualTexture(output, layout, [&](int mip, int x, int y) {
+        if (mip != encodedMip)
+            encodeLevel(mip);
+        return std::move(tiles[(size_t)y * layout.pagesAtMip(mip) + x]);
+    });
+    if (!written)
+    {
+        std::cout << "Failed to write " << output << std::endl;
+        return false;
+    }
+    printf("  %d pages, %.1f MB on disk\n", layout.pageCount(), layout.pageCount() * layout.tileBytes() / (1024.0 * 1024.0));
+    return true;
+}
@@ -0,0 +1,24 @@
+#ifndef VIRTUAL_TEXTURE_BAKER_H
+#define VIRTUAL_TEXTURE_BAKER_H
+
+#include <string>
+#include <vector>
+#include "TextureEncoder.h"
+
+struct VirtualBakeSettings {
+    BlockFormat format = BlockFormat::BC7;
+    EncodePreset preset = EncodePreset::Quality;
+    int threads = 0;
+    int tileSize = 128;  // texels of each page, excluding the border
+    int border = 4;      // texels shared with neighbouring pages, for filtering
+    // Inputs are equally sized images laid out this many per row, the first
+    // row at the top, together forming one square image of a power of two
+    // number of pages per side
+    int gridColumns = 1;
+};
+
+// Builds the mip chain of the assembled image, cuts every level into
+// bordered pages and writes them block compressed as a .vtp page file
+bool bakeVirtualTexture(const std::vector<std::string>& inputs, const std::string& output, const VirtualBakeSettings& settings);
+
+#endif // VIRTUAL_TEXTURE_BAKER_H
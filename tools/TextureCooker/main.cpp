@@ -0,0 +1,190 @@
+// Offline texture cooker: encodes an image and its mip chain into a block
+// compressed .bct container that Texture uploads with glCompressedTexImage2D.
+//
+//   TextureCooker <input.png> [output.bct] [--format bc1|bc3|bc5|bc7]
+//                 [--preset fast|quality] [--threads N] [--no-mips]
+//   TextureCooker --pack <manifest.pack> <input>... [--format ...] [--preset ...]
+//                 [--threads N]
+//   TextureCooker --virtual <output.vtp> <input>... [--grid columns] [--tile-size N]
+//                 [--format ...] [--preset ...] [--threads N]
+//
+// --pack builds the texture arrays and atlas pages TexturePack loads.
+// --virtual builds the tiled page file VirtualTexture streams from.
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include "MipGenerator.h"
+#include "TextureContainer.h"
+#include "TextureEncoder.h"
+#include "TexturePacker.h"
+#include "VirtualTextureBaker.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+    void printUsage()
+    {
+        std::cout << "usage: TextureCooker <input> [output.bct] [--format bc1|bc3|bc5|bc7]"
+            " [--preset fast|quality] [--threads N] [--no-mips]" << std::endl;
+        std::cout << "       TextureCooker --pack <manifest.pack> <input>... [--format bc1|bc3|bc5|bc7]"
+            " [--preset fast|quality] [--threads N]" << std::endl;
+        std::cout << "       TextureCooker --virtual <output.vtp> <input>... [--grid columns] [--tile-size N]"
+            " [--format bc1|bc3|bc5|bc7] [--preset fast|quality] [--threads N]" << std::endl;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::string manifest, virtualOutput;
+    VirtualBakeSettings virtualSettings;
+    std::vector<std::string> inputs;
+    BlockFormat format = BlockFormat::BC7;
+    EncodePreset preset = EncodePreset::Quality;
+    int threads = 0;
+    bool mips = true;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--format" && i + 1 < argc)
+        {
+            if (!parseBlockFormat(argv[++i], format))
+            {
+                std::cout << "Unknown format: " << argv[i] << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--preset" && i + 1 < argc)
+        {
+            std::string name = argv[++i];
+            if (name == "fast")
+                preset = EncodePreset::Fast;
+            else if (name == "quality")
+                preset = EncodePreset::Quality;
+            else
+            {
+                std::cout << "Unknown preset: " << name << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--threads" && i + 1 < argc)
+            threads = atoi(argv[++i]);
+        else if (arg == "--no-mips")
+            mips = false;
+        else if (arg == "--pack" && i + 1 < argc)
+            manifest = argv[++i];
+        else if (arg == "--virtual" && i + 1 < argc)
+            virtualOutput = argv[++i];
+        else if (arg == "--grid" && i + 1 < argc)
+            virtualSettings.gridColumns = atoi(argv[++i]);
+        else if (arg == "--tile-size" && i + 1 < argc)
+            virtualSettings.tileSize = atoi(argv[++i]);
+        else if (arg.rfind("--", 0) == 0)
+        {
+            printUsage();
+            return 1;
+        }
+        else
+            inputs.push_back(arg);
+    }
+    if (!manifest.empty())
+    {
+        if (inputs.empty())
+        {
+            printUsage();
+            return 1;
+        }
+
+        PackSettings settings;
+        settings.format = format;
+        settings.preset = preset;
+        settings.threads = threads;
+        std::cout << "Packing " << inputs.size() << " textures (" << blockFormatName(format) << ")" << std::endl;
+        return packTextures(inputs, manifest, settings) ? 0 : 1;
+    }
+    if (!virtualOutput.empty())
+    {
+        if (inputs.empty())
+        {
+            printUsage();
+            return 1;
+        }
+        virtualSettings.format = format;
+        virtualSettings.preset = preset;
+        virtualSettings.threads = threads;
+        return bakeVirtualTexture(inputs, virtualOutput, virtualSettings) ? 0 : 1;
+    }
+    if (inputs.empty() || inputs.size() > 2)
+    {
+        printUsage();
+        return 1;
+    }
+    std::string input = inputs[0];
+    std::string output = inputs.size() > 1 ? inputs[1] : std::string();
+    if (output.empty())
+        output = std::filesystem::path(input).replace_extension(".bct").string();
+
+    // Texture flips on load, so the cooked rows must be stored the same way
+    stbi_set_flip_vertically_on_load(1);
+    int width = 0, height = 0, channels = 0;
+    unsigned char* pixels = stbi_load(input.c_str(), &width, &height, &channels, 4);
+    if (!pixels)
+    {
+        std::cout << "Failed to load " << input << std::endl;
+        return 1;
+    }
+
+    std::vector<MipLevel> chain;
+    if (mips)
+    {
+        chain = generateMipChain(pixels, width, height, MipFilter::Kaiser);
+    }
+    else
+    {
+        chain.push_back({ width, height, std::vector<unsigned char>(pixels, pixels + (size_t)width * height * 4) });
+    }
+    stbi_image_free(pixels);
+
+    CompressedImage image;
+    image.format = format;
+    image.glInternalFormat = glInternalFormat(format);
+    image.width = width;
+    image.height = height;
+
+    std::cout << input << " -> " << output << " (" << blockFormatName(format) << ", "
+        << (preset == EncodePreset::Fast ? "fast" : "quality") << ")" << std::endl;
+
+    size_t rawBytes = 0, compressedBytes = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t level = 0; level < chain.size(); level++)
+    {
+        const MipLevel& mip = chain[level];
+        auto levelStart = std::chrono::high_resolution_clock::now();
+        CompressedLevel compressed = { mip.width, mip.height,
+            encodeBlocks(mip.pixels.data(), mip.width, mip.height, format, preset, threads) };
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - levelStart).count();
+
+        std::vector<uint8_t> decoded = decodeBlocks(compressed.data.data(), mip.width, mip.height, format);
+        double psnr = computePSNR(mip.pixels.data(), decoded.data(), mip.width, mip.height, format);
+        printf("  level %2zu  %5dx%-5d  PSNR %6.2f dB  %8.2f ms\n", level, mip.width, mip.height, psnr, ms);
+
+        rawBytes += mip.pixels.size();
+        compressedBytes += compressed.data.size();
+        image.levels.push_back(std::move(compressed));
+    }
+    double totalMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    if (!writeTextureContainer(output, image))
+    {
+        std::cout << "Failed to write " << output << std::endl;
+        return 1;
+    }
+    printf("  %zu levels, %.1f KB -> %.1f KB (%.1fx smaller than RGBA8), %.1f ms\n", chain.size(),
+        rawBytes / 1024.0, compressedBytes / 1024.0, (double)rawBytes / compressedBytes, totalMs);
+    return 0;
+}